@@ -0,0 +1,551 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "ChsVertexWelder.h"
+#include "ChsMeshData.h"
+#include "ChsMeshBuilder.h"
+#include "ChsMeshPipeline.h"
+#include "ChsIndexCodec.h"
+#include "ChsVertexCodec.h"
+#include "ChsGeometryCodec.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Maya free timings of the export stages on fixed inputs, so runs compare across machines and
+//	changes. Every time is the best of a few runs, each run repeating the work until it took long
+//	enough for the clock. Run on one thread, with nothing else going on.
+//	"ChsBenchmark index geometry weld" runs only the named benchmarks, no argument runs them all.
+//--------------------------------------------------------------------------------------------------
+enum{
+  BENCHMARK_RUNS = 5,
+  BENCHMARK_RUN_MICROSECONDS = 20000,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	seconds one call of work takes, best over the runs
+//--------------------------------------------------------------------------------------------------
+template <typename Work> double bestSeconds( Work & work ){
+  double best = 1e30;
+  for( int run = 0; run < BENCHMARK_RUNS; run++ ){
+    boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+    long long elapsed = 0;
+    int callCount = 0;
+    do{
+      work();
+      callCount++;
+      elapsed = ( boost::posix_time::microsec_clock::universal_time() - startTime ).total_microseconds();
+    }while( elapsed < BENCHMARK_RUN_MICROSECONDS );
+    best = std::min( best, elapsed * 1e-6 / callCount );
+  }
+  return best;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Fixed input meshes: a torus with a wavy tube, rings * sides quads, uvs over the surface,
+//	built and run through the export pipeline with the given options like an exported mesh
+//--------------------------------------------------------------------------------------------------
+struct BenchmarkMesh{
+  const char * name;
+  int rings;
+  int sides;
+  const char * options;
+};
+
+//--------------------------------------------------------------------------------------------------
+void makeTorusData( ChsMeshData & data, int rings, int sides ){
+  const float pi2 = 6.2831853f;
+  data.clear();
+  for( int ring = 0; ring < rings; ring++ ){
+    for( int side = 0; side < sides; side++ ){
+      float u = ring * pi2 / rings, v = side * pi2 / sides;
+      float tube = 1.0f + 0.3f * sinf( 5.0f * u );
+      float radius = 3.0f + cosf( v ) * tube;
+      data.points.push_back( radius * cosf( u ) );
+      data.points.push_back( radius * sinf( u ) );
+      data.points.push_back( sinf( v ) * tube );
+      data.normals.push_back( cosf( v ) * cosf( u ) );
+      data.normals.push_back( cosf( v ) * sinf( u ) );
+      data.normals.push_back( sinf( v ) );
+      data.uvs.push_back( (float)ring / rings );
+      data.uvs.push_back( (float)side / sides );
+    }
+  }
+  for( int ring = 0; ring < rings; ring++ ){
+    for( int side = 0; side < sides; side++ ){
+      int nextRing = ( ring + 1 ) % rings, nextSide = ( side + 1 ) % sides;
+      int quad[4] = { ring * sides + side, nextRing * sides + side, nextRing * sides + nextSide,
+                      ring * sides + nextSide };
+      data.polygonCounts.push_back( 4 );
+      for( int k = 0; k < 4; k++ ){
+        data.vertexIds.push_back( quad[k] );
+        data.normalIds.push_back( quad[k] );
+        data.uvIds.push_back( quad[k] );
+      }
+      int triangles[6] = { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] };
+      data.triangleCounts.push_back( 2 );
+      data.triangleVertices.insert( data.triangleVertices.end(), triangles, triangles + 6 );
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsMeshSharedPtr buildBenchmarkMesh( const BenchmarkMesh & input, const char * codecOptions = "" ){
+  ChsMeshData data;
+  makeTorusData( data, input.rings, input.sides );
+  ChsMeshSharedPtr mesh( new ChsMesh );
+  mesh->name = input.name;
+  mesh->hasTexture = true;
+  buildMesh( data, mesh );
+  ChsExportOptions options;
+  parseExportOptions( std::string( input.options ) + ";" + codecOptions, options );
+  ChsMeshReport report;
+  runMeshPipeline( mesh, options, report );
+  return mesh;
+}
+
+//--------------------------------------------------------------------------------------------------
+struct IndexEncodeWork{
+  const std::vector<unsigned int> * indices;
+  const std::vector<ChsSubmesh> * submeshes;
+  std::vector<unsigned char> buffer;
+  std::vector<size_t> sizes;
+
+  void operator()( void ){
+    size_t offset = 0;
+    for( size_t i = 0; i < submeshes->size(); i++ ){
+      const ChsSubmesh & submesh = ( *submeshes )[i];
+      sizes[i] = encodeIndexBuffer( buffer.data() + offset, buffer.size() - offset, indices->data() + submesh.firstIndex,
+                                    submesh.indexCount );
+      offset += sizes[i];
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+struct IndexDecodeWork{
+  const std::vector<ChsSubmesh> * submeshes;
+  const std::vector<unsigned char> * buffer;
+  const std::vector<size_t> * sizes;
+  std::vector<unsigned char> decoded;
+  int indexSize;
+  bool isFailed;
+
+  void operator()( void ){
+    size_t offset = 0;
+    for( size_t i = 0; i < submeshes->size(); i++ ){
+      const ChsSubmesh & submesh = ( *submeshes )[i];
+      if( decodeIndexBuffer( decoded.data() + submesh.firstIndex * indexSize, submesh.indexCount, indexSize,
+                             buffer->data() + offset, ( *sizes )[i] ) != 0 )
+        isFailed = true;
+      offset += ( *sizes )[i];
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	what a loader does with an uncompressed index block, copy it into the buffer it uploads from
+//--------------------------------------------------------------------------------------------------
+struct RawReadWork{
+  const std::vector<unsigned char> * raw;
+  std::vector<unsigned char> destination;
+
+  void operator()( void ){
+    memcpy( destination.data(), raw->data(), raw->size() );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	triangles may come back rotated, never reordered
+//--------------------------------------------------------------------------------------------------
+bool isSameTriangleList( const std::vector<unsigned int> & indices, const unsigned char * decoded, int indexSize ){
+  for( size_t i = 0; i < indices.size(); i += 3 ){
+    unsigned int corners[3];
+    for( int k = 0; k < 3; k++ ){
+      unsigned short shortIndex;
+      if( indexSize == 2 )
+        memcpy( &shortIndex, decoded + ( i + k ) * 2, 2 );
+      else
+        memcpy( &corners[k], decoded + ( i + k ) * 4, 4 );
+      corners[k] = indexSize == 2 ? shortIndex : corners[k];
+    }
+    bool isSame = false;
+    for( int rotation = 0; rotation < 3; rotation++ ){
+      isSame = isSame || ( corners[0] == indices[i + rotation] && corners[1] == indices[i + ( rotation + 1 ) % 3] &&
+                           corners[2] == indices[i + ( rotation + 2 ) % 3] );
+    }
+    if( !isSame )
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	encodes and decodes the index list one submesh at a time like the index block does, against
+//	copying the raw 16 or 32 bit indices; throughputs are in raw index bytes
+//--------------------------------------------------------------------------------------------------
+bool benchmarkIndexCodec( const ChsMesh & mesh ){
+  std::vector<unsigned int> indices;
+  mesh.getIndexArray( indices );
+  int indexSize = mesh.isShort ? 2 : 4;
+  std::vector<unsigned char> raw( indices.size() * indexSize );
+  if( mesh.isShort && !raw.empty() )
+    memcpy( raw.data(), mesh.usIndexArray.data(), raw.size() );
+  else if( !raw.empty() )
+    memcpy( raw.data(), mesh.uiIndexArray.data(), raw.size() );
+  IndexEncodeWork encodeWork;
+  encodeWork.indices = &indices;
+  encodeWork.submeshes = &mesh.submeshes;
+  size_t bound = 0;
+  for( size_t i = 0; i < mesh.submeshes.size(); i++ )
+    bound += encodeIndexBufferBound( mesh.submeshes[i].indexCount );
+  encodeWork.buffer.resize( bound );
+  encodeWork.sizes.resize( mesh.submeshes.size() );
+  double encodeSeconds = bestSeconds( encodeWork );
+  size_t encodedSize = 0;
+  for( size_t i = 0; i < encodeWork.sizes.size(); i++ ){
+    if( encodeWork.sizes[i] == 0 && mesh.submeshes[i].indexCount > 0 )
+      return false;
+    encodedSize += encodeWork.sizes[i];
+  }
+  IndexDecodeWork decodeWork;
+  decodeWork.submeshes = &mesh.submeshes;
+  decodeWork.buffer = &encodeWork.buffer;
+  decodeWork.sizes = &encodeWork.sizes;
+  decodeWork.decoded.resize( raw.size() );
+  decodeWork.indexSize = indexSize;
+  decodeWork.isFailed = false;
+  double decodeSeconds = bestSeconds( decodeWork );
+  if( decodeWork.isFailed || !isSameTriangleList( indices, decodeWork.decoded.data(), indexSize ) )
+    return false;
+  RawReadWork rawWork;
+  rawWork.raw = &raw;
+  rawWork.destination.resize( raw.size() );
+  double rawSeconds = bestSeconds( rawWork );
+  int triangleCount = indices.size() / 3;
+  printf( "index codec: %s, %d triangles, %d bit: %.3f bytes per triangle against %d raw, encode %.0f MB/s, "
+          "decode %.2f GB/s, raw read %.2f GB/s\n", mesh.name.c_str(), triangleCount, indexSize * 8,
+          (double)encodedSize / triangleCount, indexSize * 3, raw.size() / encodeSeconds * 1e-6,
+          raw.size() / decodeSeconds * 1e-9, raw.size() / rawSeconds * 1e-9 );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool benchmarkIndexCodec( void ){
+  static const BenchmarkMesh inputs[] = {
+    { "torus 32k", 100, 160, "" },
+    { "torus 1M", 625, 800, "" },
+    { "torus 1M split", 625, 800, "splitMeshes=1" },
+  };
+  for( size_t i = 0; i < sizeof( inputs ) / sizeof( inputs[0] ); i++ ){
+    if( !benchmarkIndexCodec( *buildBenchmarkMesh( inputs[i] ) ) ){
+      printf( "index codec: %s does not round trip\n", inputs[i].name );
+      return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	one codec stream per vertex range, holding all submeshes of the range like encodeGeometryRanges
+//	groups them, with the attributes it codes at the default bits
+//--------------------------------------------------------------------------------------------------
+struct GeometryRange{
+  int firstVertex;
+  int vertexCount;
+  std::vector<unsigned int> indices;
+  std::vector<int> indexCounts;
+  std::vector<unsigned char> stream;
+};
+
+//--------------------------------------------------------------------------------------------------
+void makeGeometryRanges( const ChsMesh & mesh, std::vector<GeometryRange> & ranges ){
+  std::vector<unsigned int> indices;
+  mesh.getIndexArray( indices );
+  int submeshCount = mesh.submeshes.size();
+  std::vector<bool> isDone( submeshCount, false );
+  for( int i = 0; i < submeshCount; i++ ){
+    if( isDone[i] )
+      continue;
+    GeometryRange range;
+    range.firstVertex = mesh.submeshes[i].firstVertex;
+    range.vertexCount = mesh.submeshes[i].vertexCount;
+    for( int j = i; j < submeshCount; j++ ){
+      const ChsSubmesh & submesh = mesh.submeshes[j];
+      if( !isDone[j] && submesh.firstVertex == range.firstVertex && submesh.vertexCount == range.vertexCount ){
+        range.indices.insert( range.indices.end(), indices.begin() + submesh.firstIndex,
+                              indices.begin() + submesh.firstIndex + submesh.indexCount );
+        range.indexCounts.push_back( submesh.indexCount );
+        isDone[j] = true;
+      }
+    }
+    ranges.push_back( range );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeGeometryAttributes( const ChsMesh & mesh, std::vector<ChsGeometryAttribute> & attributes ){
+  ChsExportOptions options;
+  ChsGeometryAttribute position = { CHS_GEOMETRY_LINEAR, 3, options.positionBits, 0 };
+  attributes.push_back( position );
+  ChsGeometryAttribute normal = { CHS_GEOMETRY_NORMAL, 3, 10, 3 };
+  attributes.push_back( normal );
+  int offset = 6;
+  if( mesh.hasUV && mesh.hasTexture ){
+    ChsGeometryAttribute texcoord = { CHS_GEOMETRY_LINEAR, 2, options.texcoordBits, offset };
+    attributes.push_back( texcoord );
+    offset += 2;
+  }
+  if( mesh.hasVertexColor ){
+    ChsGeometryAttribute color = { CHS_GEOMETRY_LINEAR, 4, 8, offset };
+    attributes.push_back( color );
+    offset += 4;
+  }
+  if( mesh.hasTangent ){
+    ChsGeometryAttribute tangent = { CHS_GEOMETRY_TANGENT, 4, 10, offset };
+    attributes.push_back( tangent );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the triangles come in traversal order from the pipeline, as encodeGeometry wants them
+//--------------------------------------------------------------------------------------------------
+struct GeometryEncodeWork{
+  const ChsMesh * mesh;
+  std::vector<GeometryRange> * ranges;
+  std::vector<ChsGeometryAttribute> attributes;
+  bool isFailed;
+
+  void operator()( void ){
+    int stride = mesh->vertexStride();
+    for( size_t i = 0; i < ranges->size(); i++ ){
+      GeometryRange & range = ( *ranges )[i];
+      if( !encodeGeometry( range.stream, &mesh->vertexArray[(size_t)range.firstVertex * stride], range.vertexCount,
+                           stride, attributes.data(), attributes.size(), range.indices.data(),
+                           range.indexCounts.data(), range.indexCounts.size() ) )
+        isFailed = true;
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	ranges decode one after the other into the same buffers, like a loader streaming them
+//--------------------------------------------------------------------------------------------------
+struct GeometryDecodeWork{
+  const std::vector<GeometryRange> * ranges;
+  int vertexStride;
+  std::vector<float> vertices;
+  std::vector<unsigned int> indices;
+  bool isFailed;
+
+  void operator()( void ){
+    for( size_t i = 0; i < ranges->size(); i++ ){
+      const GeometryRange & range = ( *ranges )[i];
+      if( decodeGeometry( vertices.data(), range.vertexCount, vertexStride, indices.data(), range.indices.size(),
+                          range.stream.data(), range.stream.size() ) != 0 )
+        isFailed = true;
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	size prefixed, 4 byte padded streams as the pipeline lays out the vertex and index codec blocks
+//--------------------------------------------------------------------------------------------------
+struct CodecStream{
+  const unsigned char * data;
+  size_t size;
+};
+
+bool splitCodecStreams( const std::vector<unsigned char> & block, std::vector<CodecStream> & streams ){
+  size_t position = 0;
+  while( position < block.size() ){
+    unsigned int size;
+    if( block.size() - position < sizeof( size ) )
+      return false;
+    memcpy( &size, &block[position], sizeof( size ) );
+    position += sizeof( size );
+    if( block.size() - position < size )
+      return false;
+    CodecStream stream = { &block[position], size };
+    streams.push_back( stream );
+    position = std::min( position + ( ( size + 3 ) & ~3u ), block.size() );
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	what a loader of the quantized vertex codec and index codec blocks does instead
+//--------------------------------------------------------------------------------------------------
+struct VertexCodecDecodeWork{
+  const ChsMesh * mesh;
+  std::vector<CodecStream> vertexStreams;
+  std::vector<CodecStream> indexStreams;
+  std::vector<unsigned char> vertexData;
+  std::vector<unsigned char> indices;
+  bool isFailed;
+
+  void operator()( void ){
+    int vertexCount = mesh->vertexCount(), indexSize = mesh->isShort ? 2 : 4;
+    for( size_t i = 0; i < vertexStreams.size(); i++ ){
+      const ChsVertexStream & stream = mesh->streams[i];
+      if( decodeVertexBuffer( &vertexData[stream.offset], vertexCount, stream.stride, vertexStreams[i].data,
+                              vertexStreams[i].size ) != 0 )
+        isFailed = true;
+    }
+    for( size_t i = 0; i < indexStreams.size(); i++ ){
+      const ChsSubmesh & submesh = mesh->submeshes[i];
+      if( decodeIndexBuffer( &indices[(size_t)submesh.firstIndex * indexSize], submesh.indexCount, indexSize,
+                             indexStreams[i].data, indexStreams[i].size ) != 0 )
+        isFailed = true;
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	encodes and decodes the geometry codec streams of a mesh exported with them, against the same
+//	mesh exported quantized with the vertex and index codecs and against the raw float blocks
+//--------------------------------------------------------------------------------------------------
+bool benchmarkGeometryCodec( const BenchmarkMesh & input ){
+  ChsMeshSharedPtr mesh = buildBenchmarkMesh( input, "geometryCodec=1" );
+  if( mesh->encodedGeometry.empty() )
+    return false;
+  std::vector<GeometryRange> ranges;
+  makeGeometryRanges( *mesh, ranges );
+  GeometryEncodeWork encodeWork;
+  encodeWork.mesh = mesh.get();
+  encodeWork.ranges = &ranges;
+  makeGeometryAttributes( *mesh, encodeWork.attributes );
+  encodeWork.isFailed = false;
+  double encodeSeconds = bestSeconds( encodeWork );
+  if( encodeWork.isFailed )
+    return false;
+  GeometryDecodeWork decodeWork;
+  decodeWork.ranges = &ranges;
+  decodeWork.vertexStride = mesh->vertexStride();
+  size_t maxVertexCount = 0, maxIndexCount = 0, encodedSize = 0;
+  for( size_t i = 0; i < ranges.size(); i++ ){
+    maxVertexCount = std::max( maxVertexCount, (size_t)ranges[i].vertexCount );
+    maxIndexCount = std::max( maxIndexCount, ranges[i].indices.size() );
+    encodedSize += sizeof( unsigned int ) + ( ( ranges[i].stream.size() + 3 ) & ~3u );
+  }
+  //the same streams the pipeline wrote
+  if( encodedSize != mesh->encodedGeometry.size() )
+    return false;
+  decodeWork.vertices.resize( maxVertexCount * decodeWork.vertexStride );
+  decodeWork.indices.resize( maxIndexCount );
+  decodeWork.isFailed = false;
+  double decodeSeconds = bestSeconds( decodeWork );
+  if( decodeWork.isFailed )
+    return false;
+  ChsMeshSharedPtr codecMesh = buildBenchmarkMesh( input, "quantize=1;vertexCodec=1;indexCodec=1" );
+  VertexCodecDecodeWork codecWork;
+  codecWork.mesh = codecMesh.get();
+  if( !splitCodecStreams( codecMesh->encodedVertexData, codecWork.vertexStreams ) ||
+      !splitCodecStreams( codecMesh->encodedIndexArray, codecWork.indexStreams ) ||
+      codecWork.vertexStreams.size() != codecMesh->streams.size() ||
+      codecWork.indexStreams.size() != codecMesh->submeshes.size() )
+    return false;
+  codecWork.vertexData.resize( codecMesh->vertexData.size() );
+  codecWork.indices.resize( codecMesh->indexCount() * ( codecMesh->isShort ? 2 : 4 ) );
+  codecWork.isFailed = false;
+  double codecSeconds = bestSeconds( codecWork );
+  if( codecWork.isFailed || codecWork.vertexData != codecMesh->vertexData )
+    return false;
+  int vertexCount = mesh->vertexCount(), triangleCount = mesh->indexCount() / 3;
+  size_t rawSize = mesh->vertexArray.size() * sizeof( float ) + mesh->indexCount() * ( mesh->isShort ? 2 : 4 );
+  size_t codecSize = codecMesh->encodedVertexData.size() + codecMesh->encodedIndexArray.size();
+  printf( "geometry codec: %s, %d vertices, %d triangles, %d ranges: %.2f bytes per vertex against %.2f vertex and "
+          "index codec before lz4, %.2f raw, encode %.2f ms, decode %.2f ms, vertex and index codec decode %.2f ms\n",
+          input.name, vertexCount, triangleCount, (int)ranges.size(), (double)encodedSize / vertexCount,
+          (double)codecSize / codecMesh->vertexCount(), (double)rawSize / vertexCount, encodeSeconds * 1e3,
+          decodeSeconds * 1e3, codecSeconds * 1e3 );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool benchmarkGeometryCodec( void ){
+  static const BenchmarkMesh inputs[] = {
+    { "torus 32k", 100, 160, "" },
+    { "torus 1M", 625, 800, "" },
+    { "torus 1M split", 625, 800, "splitMeshes=1" },
+  };
+  for( size_t i = 0; i < sizeof( inputs ) / sizeof( inputs[0] ); i++ ){
+    if( !benchmarkGeometryCodec( inputs[i] ) ){
+      printf( "geometry codec: %s does not round trip\n", inputs[i].name );
+      return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	same fields as the builder's unit, so the table does the same work
+//--------------------------------------------------------------------------------------------------
+struct WeldUnit{
+  int vertexId;
+  int normalId;
+  int uvId;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	corners come polygon by polygon like Maya lists them, every grid vertex shared by 4 quads
+//--------------------------------------------------------------------------------------------------
+struct WeldWork{
+  int side;
+  ChsVertexWelder<WeldUnit> welder;
+
+  void operator()( void ){
+    static const int cornerX[4] = { 0, 1, 1, 0 };
+    static const int cornerY[4] = { 0, 0, 1, 1 };
+    welder.reset( side * side * 4 );
+    for( int y = 0; y < side; y++ ){
+      for( int x = 0; x < side; x++ ){
+        for( int corner = 0; corner < 4; corner++ ){
+          int vertexId = ( y + cornerY[corner] ) * ( side + 1 ) + x + cornerX[corner];
+          WeldUnit unit = { vertexId, vertexId, vertexId };
+          welder.weld( unit );
+        }
+      }
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	square quad grids from 10k up to 10M corners, the work per corner is constant, so the time
+//	per corner only grows as the table falls out of the caches
+//--------------------------------------------------------------------------------------------------
+void benchmarkWeld( void ){
+  static const int cornerCounts[] = { 10000, 100000, 1000000, 10000000 };
+  WeldWork work;
+  for( size_t i = 0; i < sizeof( cornerCounts ) / sizeof( cornerCounts[0] ); i++ ){
+    work.side = (int)( sqrt( cornerCounts[i] / 4.0 ) + 0.5 );
+    double seconds = bestSeconds( work );
+    int cornerCount = work.side * work.side * 4;
+    printf( "weld: %d corners -> %d vertices, %.2f ms, %.2f ns per corner\n", cornerCount, work.welder.count(),
+            seconds * 1e3, seconds * 1e9 / cornerCount );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static bool isSelected( int argc, char ** argv, const char * name ){
+  for( int i = 1; i < argc; i++ ){
+    if( strcmp( argv[i], name ) == 0 )
+      return true;
+  }
+  return argc < 2;
+}
+
+//--------------------------------------------------------------------------------------------------
+int main( int argc, char ** argv ){
+  bool isPassed = true;
+  if( isSelected( argc, argv, "index" ) )
+    isPassed = benchmarkIndexCodec() && isPassed;
+  if( isSelected( argc, argv, "geometry" ) )
+    isPassed = benchmarkGeometryCodec() && isPassed;
+  if( isSelected( argc, argv, "weld" ) )
+    benchmarkWeld();
+  return isPassed ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -11,6 +11,9 @@
 #include <maya/MPoint.h>
 #include <maya/MIntArray.h>
 #include <maya/MFloatArray.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MFloatVectorArray.h>
+#include <maya/MColorArray.h>
 #include <maya/MFnDagNode.h>
 #include <maya/MFnSet.h>
 #include <maya/MPlugArray.h>
@@ -19,19 +22,35 @@
 #include <maya/MItDependencyGraph.h>
 #include <maya/MFnAnimCurve.h>
 #include <maya/MDistance.h>
+#include <maya/MFnTransform.h>
+#include <maya/MTransformationMatrix.h>
 
 #include <vector>
 #include <fstream>
+#include <algorithm>
 #include <boost/any.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/assign.hpp>
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 using namespace boost::assign;
 #include <limits.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "ChaosExport.h"
+#include "ChsMesh.h"
+#include "ChsMeshData.h"
+#include "ChsMeshBuilder.h"
+#include "ChsMeshPipeline.h"
+#include "ChsStaticBatcher.h"
+#include "ChsParallel.h"
+#include "ChsChunkCompressor.h"
+#include "ChsFileWriter.h"
+#include "ChsModelWriter.h"
+#include "ChsModelReader.h"
 #include "tinyxml2.h"
 using namespace tinyxml2;
 
@@ -40,47 +59,21 @@ static XMLDocument xmlFile;
 static XMLElement * modelElement = NULL;
 static MString extension = "chsmodel";
 static MString magicHeader = "chmo";
+static ChsExportOptions exportOptions;
 
-struct ChsMesh{
-  bool isShort;
-  bool hasVertexColor;
-  bool hasUV;
-  bool hasTexture;
-  bool isAnimated;
-  std::vector<float> vertexArray;
-  std::vector<unsigned short> usIndexArray;
-  std::vector<unsigned int> uiIndexArray;
-  float transform[4][4];
-  
-  void addPosition( const MPoint & pos ){
-    this->vertexArray += pos.x, pos.y, pos.z;
-  }
-  
-  void addNormal( const MVector & normal ){
-    this->vertexArray += normal.x, normal.y, normal.z;    
-  }
-  
-  void addUV( float u, float v){
-    this->vertexArray += u, v; 
-  }
-  
-  void addColor( const MColor & color ){
-    this->vertexArray += color.r, color.g, color.b, color.a;
-  }
-  
-  void addIndexValue( int indexValue ){
-    if( isShort ){
-      this->usIndexArray += indexValue;
-    }
-    else {
-      this->uiIndexArray += indexValue;
-    }
-  }
-  
-};
-
-typedef boost::shared_ptr<ChsMesh> ChsMeshSharedPtr;
 static std::vector< ChsMeshSharedPtr > meshList;
+static int exportedMeshCount = 0;
+//static batches still filling up, they carry over from one stream window to the next
+static ChsBatchState batchState;
+
+//version 2 exports stream, meshList then only holds the meshes not written yet
+static boost::scoped_ptr<ChsFileWriter> streamFile;
+static boost::scoped_ptr<ChsModelWriter> streamWriter;
+//the stream goes to a file next to the target, renamed over it only once complete
+static MString streamTempName;
+static boost::posix_time::ptime streamStartTime;
+static int streamPeakMeshes = 0;
+static size_t streamPeakBytes = 0;
 
 enum Format{
   UNKNOWN_FORMAT = -1,
@@ -88,28 +81,6 @@ enum Format{
   BINARY_FORMAT,
 }format;
 
-//--------------------------------------------------------------------------------------------------
-enum{
-  POSITION,
-  NORMAL,
-  TEXCOORD0,
-  COLOR,
-};
-
-struct Attribute{
-  MString id;
-  int stride;
-  MString type;
-};
-
-static Attribute attributes[]={
-  { "position",    3, "GL_FLOAT" },
-  { "normal",      3, "GL_FLOAT" },
-  { "texcoord0",   2, "GL_FLOAT" },
-  { "vertexColor", 4, "GL_FLOAT" },
-};
-
-
 //--------------------------------------------------------------------------------------------------
 enum ChsAnimCurveName{
   CHS_ANIMCURVE_VISIBILITY,
@@ -150,8 +121,8 @@ struct AnimCurve{
 std::vector<AnimCurve> animCurveList[CHS_ANIMCURVE_MAX];
 
 //--------------------------------------------------------------------------------------------------
-template<typename T> void writeValueToFile( std::ofstream & ofs, T * value, int count ){
-  ofs.write( (const char * )value, sizeof(T) * count );
+template<typename T> void writeValueToFile( ChsOutputSink & sink, T * value, int count ){
+  sink.write( value, sizeof(T) * count );
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -176,16 +147,28 @@ void initXMLFile( void ){
 }
 
 //--------------------------------------------------------------------------------------------------
-void writeBinaryPartToFile( std::ofstream & newFile ){
+void writeBinaryPartToFile( ChsOutputSink & newFile ){
   int meshCount = meshList.size();
   //write vertex and index data
   for( int meshIdx = 0; meshIdx < meshCount; meshIdx++ ){
     ChsMeshSharedPtr & mesh = meshList[meshIdx];
-    int countOfVertex = mesh->vertexArray.size();
-    int sizeOfVertex =  countOfVertex * sizeof( float );
+    const std::vector<unsigned char> & vertexBlock = !mesh->encodedGeometry.empty() ? mesh->encodedGeometry :
+                                                     !mesh->encodedVertexData.empty() ? mesh->encodedVertexData :
+                                                     mesh->vertexData;
+    int sizeOfVertex = vertexBlock.size();
     writeValueToFile( newFile, &sizeOfVertex, 1 );
-    writeValueToFile( newFile, mesh->vertexArray.data(), countOfVertex );
-    if( mesh->isShort ){
+    writeValueToFile( newFile, vertexBlock.data(), sizeOfVertex );
+    if( !mesh->encodedGeometry.empty() ){
+      //the indices are in the geometry streams
+      int sizeOfIndex = 0;
+      writeValueToFile( newFile, &sizeOfIndex, 1 );
+    }
+    else if( !mesh->encodedIndexArray.empty() ){
+      int sizeOfIndex = mesh->encodedIndexArray.size();
+      writeValueToFile( newFile, &sizeOfIndex, 1 );
+      writeValueToFile( newFile, mesh->encodedIndexArray.data(), sizeOfIndex );
+    }
+    else if( mesh->isShort ){
       int countOfIndex = mesh->usIndexArray.size();
       int sizeOfIndex = countOfIndex * sizeof( unsigned short );
       writeValueToFile( newFile, &sizeOfIndex, 1 );
@@ -197,53 +180,325 @@ void writeBinaryPartToFile( std::ofstream & newFile ){
       writeValueToFile( newFile, &sizeOfIndex, 1 );
       writeValueToFile( newFile, mesh->uiIndexArray.data(), countOfIndex );
     }
+    if( !mesh->meshlets.empty() ){
+      int sizeOfMeshlet = mesh->meshlets.size() * sizeof( ChsMeshlet );
+      writeValueToFile( newFile, &sizeOfMeshlet, 1 );
+      writeValueToFile( newFile, mesh->meshlets.data(), mesh->meshlets.size() );
+      int sizeOfMeshletVertex = mesh->meshletVertices.size() * sizeof( unsigned int );
+      writeValueToFile( newFile, &sizeOfMeshletVertex, 1 );
+      writeValueToFile( newFile, mesh->meshletVertices.data(), mesh->meshletVertices.size() );
+      int sizeOfMeshletTriangle = mesh->meshletTriangles.size();
+      writeValueToFile( newFile, &sizeOfMeshletTriangle, 1 );
+      writeValueToFile( newFile, mesh->meshletTriangles.data(), mesh->meshletTriangles.size() );
+    }
+    BOOST_FOREACH( const ChsLod & lod, mesh->lods ){
+      int countOfIndex = lod.indices.size();
+      if( !lod.encodedIndices.empty() ){
+        int sizeOfIndex = lod.encodedIndices.size();
+        writeValueToFile( newFile, &sizeOfIndex, 1 );
+        writeValueToFile( newFile, lod.encodedIndices.data(), sizeOfIndex );
+      }
+      else if( mesh->isShort ){
+        std::vector<unsigned short> usIndexArray( lod.indices.begin(), lod.indices.end() );
+        int sizeOfIndex = countOfIndex * sizeof( unsigned short );
+        writeValueToFile( newFile, &sizeOfIndex, 1 );
+        writeValueToFile( newFile, usIndexArray.data(), countOfIndex );
+      }
+      else{
+        int sizeOfIndex = countOfIndex * sizeof( unsigned int );
+        writeValueToFile( newFile, &sizeOfIndex, 1 );
+        writeValueToFile( newFile, lod.indices.data(), countOfIndex );
+      }
+    }
+    if( !mesh->depthIndices.empty() ){
+      int sizeOfPosition = mesh->depthPositions.size();
+      writeValueToFile( newFile, &sizeOfPosition, 1 );
+      writeValueToFile( newFile, mesh->depthPositions.data(), sizeOfPosition );
+      int countOfIndex = mesh->depthIndices.size();
+      if( mesh->isDepthShort() ){
+        std::vector<unsigned short> usIndexArray( mesh->depthIndices.begin(), mesh->depthIndices.end() );
+        int sizeOfIndex = countOfIndex * sizeof( unsigned short );
+        writeValueToFile( newFile, &sizeOfIndex, 1 );
+        writeValueToFile( newFile, usIndexArray.data(), countOfIndex );
+      }
+      else{
+        int sizeOfIndex = countOfIndex * sizeof( unsigned int );
+        writeValueToFile( newFile, &sizeOfIndex, 1 );
+        writeValueToFile( newFile, mesh->depthIndices.data(), countOfIndex );
+      }
+    }
   }
 }
 
 //--------------------------------------------------------------------------------------------------
-void writeXMLPartToFile( std::ofstream & newFile ){
+//	the loader reads both tables first, then decompresses every chunk in parallel
+//--------------------------------------------------------------------------------------------------
+void compressBinaryPart( std::vector<ChsCompressedChunk> & table, std::vector<unsigned char> & compressed ){
+  ChsMemoryWriter binaryPart;
+  writeBinaryPartToFile( binaryPart );
+  const std::vector<unsigned char> & data = binaryPart.buffer;
+  compressChunks( data.data(), data.size(), exportOptions.chunkSize, table, compressed );
+  modelElement->SetAttribute( "compression", "lz4" );
+  modelElement->SetAttribute( "chunkSize", exportOptions.chunkSize );
+  modelElement->SetAttribute( "chunkCount", static_cast<int>( table.size() ) );
+  modelElement->SetAttribute( "uncompressedSize", static_cast<int>( data.size() ) );
+  modelElement->SetAttribute( "compressedSize", static_cast<int>( compressed.size() ) );
+  MString info = "lz4: ";
+  info += (int)data.size();
+  info += " -> ";
+  info += (int)compressed.size();
+  info += " bytes in ";
+  info += (int)table.size();
+  info += " chunks";
+  MGlobal::displayInfo( info );
+}
+
+//--------------------------------------------------------------------------------------------------
+void writeCompressedPartToFile( ChsOutputSink & newFile, const std::vector<ChsCompressedChunk> & table,
+                                const std::vector<unsigned char> & compressed ){
+  int sizeOfTable = table.size() * sizeof( ChsCompressedChunk );
+  writeValueToFile( newFile, &sizeOfTable, 1 );
+  writeValueToFile( newFile, table.data(), table.size() );
+  int sizeOfCompressed = compressed.size();
+  writeValueToFile( newFile, &sizeOfCompressed, 1 );
+  writeValueToFile( newFile, compressed.data(), sizeOfCompressed );
+}
+
+//--------------------------------------------------------------------------------------------------
+void writeXMLPartToFile( ChsOutputSink & newFile ){
   XMLPrinter printer( NULL, true );
   xmlFile.Print( &printer );
-  int xmlFileSize = printer.CStrSize();
+  int textSize = printer.CStrSize();
+  int xmlFileSize = textSize;
   if( BINARY_FORMAT == format ){
     xmlFileSize = ( xmlFileSize + 3 ) / 4 * 4;//address align
     writeValueToFile( newFile, &xmlFileSize,1);
   }
-  boost::scoped_ptr<char> xmlBuffer( new char[xmlFileSize] );
-  memcpy( xmlBuffer.get(), printer.CStr(), xmlFileSize );
-  writeValueToFile( newFile, xmlBuffer.get(), xmlFileSize );
+  writeValueToFile( newFile, printer.CStr(), textSize );
+  const char padding[4] = { 0, 0, 0, 0 };
+  writeValueToFile( newFile, padding, xmlFileSize - textSize );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	version 2 chunks of one mesh, the blocks of writeBinaryPartToFile without their size prefixes
+//--------------------------------------------------------------------------------------------------
+template< typename T > void addVectorChunk( ChsModelWriter & writer, unsigned int type, unsigned int meshIdx,
+                                            unsigned int level, const std::vector<T> & data ){
+  writer.addChunk( type, meshIdx, level, data.data(), data.size() * sizeof( T ) );
+}
+
+template< typename T > void addShortIndexChunk( ChsModelWriter & writer, unsigned int type, unsigned int meshIdx,
+                                                unsigned int level, const std::vector<T> & indices ){
+  std::vector<unsigned short> usIndexArray( indices.begin(), indices.end() );
+  addVectorChunk( writer, type, meshIdx, level, usIndexArray );
+}
+
+//--------------------------------------------------------------------------------------------------
+void addMeshChunks( ChsModelWriter & writer, unsigned int meshIdx, const ChsMeshSharedPtr & mesh ){
+  const std::vector<unsigned char> & vertexBlock = !mesh->encodedGeometry.empty() ? mesh->encodedGeometry :
+                                                   !mesh->encodedVertexData.empty() ? mesh->encodedVertexData :
+                                                   mesh->vertexData;
+  addVectorChunk( writer, CHS_CHUNK_VERTEX, meshIdx, 0, vertexBlock );
+  //with the geometry codec the indices are in the vertex chunk
+  if( mesh->encodedGeometry.empty() ){
+    if( !mesh->encodedIndexArray.empty() )
+      addVectorChunk( writer, CHS_CHUNK_INDEX, meshIdx, 0, mesh->encodedIndexArray );
+    else if( mesh->isShort )
+      addVectorChunk( writer, CHS_CHUNK_INDEX, meshIdx, 0, mesh->usIndexArray );
+    else
+      addVectorChunk( writer, CHS_CHUNK_INDEX, meshIdx, 0, mesh->uiIndexArray );
+  }
+  if( !mesh->meshlets.empty() ){
+    addVectorChunk( writer, CHS_CHUNK_MESHLET, meshIdx, 0, mesh->meshlets );
+    addVectorChunk( writer, CHS_CHUNK_MESHLET_VERTEX, meshIdx, 0, mesh->meshletVertices );
+    addVectorChunk( writer, CHS_CHUNK_MESHLET_TRIANGLE, meshIdx, 0, mesh->meshletTriangles );
+  }
+  for( size_t i = 0; i < mesh->lods.size(); i++ ){
+    const ChsLod & lod = mesh->lods[i];
+    unsigned int level = i + 1;
+    if( !lod.encodedIndices.empty() )
+      addVectorChunk( writer, CHS_CHUNK_LOD_INDEX, meshIdx, level, lod.encodedIndices );
+    else if( mesh->isShort )
+      addShortIndexChunk( writer, CHS_CHUNK_LOD_INDEX, meshIdx, level, lod.indices );
+    else
+      addVectorChunk( writer, CHS_CHUNK_LOD_INDEX, meshIdx, level, lod.indices );
+  }
+  if( !mesh->depthIndices.empty() ){
+    addVectorChunk( writer, CHS_CHUNK_DEPTH_POSITION, meshIdx, 0, mesh->depthPositions );
+    if( mesh->isDepthShort() )
+      addShortIndexChunk( writer, CHS_CHUNK_DEPTH_INDEX, meshIdx, 0, mesh->depthIndices );
+    else
+      addVectorChunk( writer, CHS_CHUNK_DEPTH_INDEX, meshIdx, 0, mesh->depthIndices );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	drops an unfinished stream, the file at the export path stays as it was
+//--------------------------------------------------------------------------------------------------
+void abortStream( void ){
+  streamWriter.reset();
+  streamFile.reset();
+  if( streamTempName.length() > 0 )
+    remove( streamTempName.asChar() );
+  streamTempName = "";
+}
+
+//--------------------------------------------------------------------------------------------------
+MStatus beginStream( const MString & fullFileName ){
+  streamStartTime = boost::posix_time::microsec_clock::universal_time();
+  streamTempName = fullFileName + ".part";
+  streamFile.reset( new ChsFileWriter );
+  if( !streamFile->open( streamTempName.asChar() ) ){
+    MGlobal::displayError( streamTempName + ": could not be opened for writing" );
+    abortStream();
+    return MStatus::kFailure;
+  }
+  streamWriter.reset( new ChsModelWriter( *streamFile ) );
+  streamWriter->setAlignment( exportOptions.pageAlignChunks ? CHS_MODEL_PAGE_ALIGNMENT : CHS_MODEL_ALIGNMENT );
+  if( exportOptions.compressBinary )
+    streamWriter->setCompression( exportOptions.chunkSize );
+  streamWriter->begin();
+  streamPeakMeshes = 0;
+  streamPeakBytes = 0;
+  return MStatus::kSuccess;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	static batching keeps its open batches across windows, so it streams in the same window
+//--------------------------------------------------------------------------------------------------
+int streamWindowSize( void ){
+  int threadCount = boost::thread::hardware_concurrency();
+  return threadCount > 1 ? threadCount : 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the meshes of meshList have their xml elements, write their chunks and let them go;
+//	heldBytes is what the window held at its peak
+//--------------------------------------------------------------------------------------------------
+void streamMeshList( int firstMeshIdx, size_t heldBytes ){
+  for( size_t i = 0; i < meshList.size(); i++ ){
+    addMeshChunks( *streamWriter, firstMeshIdx + i, meshList[i] );
+    float boundsMin[3], boundsMax[3];
+    meshList[i]->getBounds( boundsMin, boundsMax );
+    //makeXMLPart took the name as the element id
+    streamWriter->addMeshEntry( firstMeshIdx + i, meshList[i]->name.c_str(), boundsMin, boundsMax );
+  }
+  streamPeakMeshes = std::max( streamPeakMeshes, (int)meshList.size() );
+  streamPeakBytes = std::max( streamPeakBytes, heldBytes );
+  meshList.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the xml goes last, its mesh elements only exist once every mesh went through
+//--------------------------------------------------------------------------------------------------
+MStatus finishStream( const MString & fullFileName ){
+  XMLPrinter printer( NULL, true );
+  xmlFile.Print( &printer );
+  //without the terminating zero
+  streamWriter->addChunk( CHS_CHUNK_XML, CHS_NO_MESH, 0, printer.CStr(), printer.CStrSize() - 1 );
+  bool isWritten = streamWriter->finish();
+  int chunkCount = streamWriter->chunkCount();
+  streamWriter.reset();
+  isWritten = streamFile->close() && isWritten;
+  unsigned long long bytesWritten = streamFile->bytesWritten();
+  int syscallCount = streamFile->syscallCount();
+  streamFile.reset();
+  if( !isWritten || rename( streamTempName.asChar(), fullFileName.asChar() ) != 0 ){
+    MGlobal::displayError( fullFileName + ": write failed" );
+    abortStream();
+    return MStatus::kFailure;
+  }
+  streamTempName = "";
+  boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - streamStartTime;
+  MString info = "streamed ";
+  info += chunkCount;
+  info += " chunks, ";
+  info += (double)bytesWritten;
+  info += " bytes in ";
+  info += syscallCount;
+  info += " writes, ";
+  info += elapsed.total_microseconds() * 1e-3;
+  info += " ms, at most ";
+  info += streamPeakMeshes;
+  info += " meshes and ";
+  info += (double)streamPeakBytes;
+  info += " bytes of mesh data held";
+  MGlobal::displayInfo( info );
+  return MStatus::kSuccess;
 }
 
 //--------------------------------------------------------------------------------------------------
 MStatus writeToFile( const MString & fullFileName ){
-  std::ofstream newFile( fullFileName.asChar(), ios::out );
-  if( !newFile ){
-    MGlobal::displayError( fullFileName + ": could not be opened for reading" );
+  boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+  ChsFileWriter newFile;
+  if( !newFile.open( fullFileName.asChar() ) ){
+    MGlobal::displayError( fullFileName + ": could not be opened for writing" );
     return MStatus::kFailure;
   }
-  //enable automatic flushing of the output stream after any output operation
-  newFile.setf( ios::unitbuf );
+  bool isCompressed = BINARY_FORMAT == format && exportOptions.compressBinary;
+  std::vector<ChsCompressedChunk> table;
+  std::vector<unsigned char> compressed;
+  if( isCompressed ){
+    //the chunk sizes go into the xml part, so compress before writing it
+    compressBinaryPart( table, compressed );
+  }
   if( BINARY_FORMAT == format ){
     writeValueToFile( newFile, magicHeader.asChar(),magicHeader.length() );
   }
   writeXMLPartToFile( newFile );
-  if( BINARY_FORMAT == format ){
+  if( isCompressed ){
+    writeCompressedPartToFile( newFile, table, compressed );
+  }
+  else if( BINARY_FORMAT == format ){
     writeBinaryPartToFile( newFile );
   }
-  newFile.flush();
-  newFile.close();
+  if( !newFile.close() ){
+    MGlobal::displayError( fullFileName + ": write failed" );
+    return MStatus::kFailure;
+  }
+  boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - startTime;
+  double seconds = elapsed.total_microseconds() * 1e-6;
+  MString info = "wrote ";
+  info += (double)newFile.bytesWritten();
+  info += " bytes in ";
+  info += newFile.syscallCount();
+  info += " writes, ";
+  info += seconds * 1000.0;
+  info += " ms, ";
+  info += seconds > 0.0 ? newFile.bytesWritten() / seconds / ( 1024.0 * 1024.0 ) : 0.0;
+  info += " MB/s";
+  MGlobal::displayInfo( info );
   return MStatus::kSuccess;
 }
 
 //--------------------------------------------------------------------------------------------------
-void makeAttributeElement( int type, XMLElement * meshElement ){
+void makeAttributeElement( const ChsVertexAttribute & attribute, XMLElement * meshElement ){
   XMLElement * attributeElement = xmlFile.NewElement( "ChsAttribute" );
-  attributeElement->SetAttribute( "id", attributes[type].id.asChar() );
-  attributeElement->SetAttribute( "stride", attributes[type].stride );
-  attributeElement->SetAttribute( "type", attributes[type].type.asChar() );
+  attributeElement->SetAttribute( "id", chsAttributeNames[attribute.id] );
+  attributeElement->SetAttribute( "stride", attribute.components );
+  attributeElement->SetAttribute( "type", chsAttributeTypeNames[attribute.type] );
+  attributeElement->SetAttribute( "normalized", attribute.normalized );
+  attributeElement->SetAttribute( "offset", attribute.offset );
+  if( attribute.stream > 0 )
+    attributeElement->SetAttribute( "stream", attribute.stream );
   meshElement->InsertEndChild( attributeElement );
 }
 
+//--------------------------------------------------------------------------------------------------
+//	only written for split streams, offsets are into the vertex block
+//--------------------------------------------------------------------------------------------------
+void makeVertexStreamElements( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+  if( mesh->streams.size() < 2 )
+    return;
+  for( size_t i = 0; i < mesh->streams.size(); i++ ){
+    XMLElement * streamElement = xmlFile.NewElement( "ChsVertexStream" );
+    streamElement->SetAttribute( "index", (int)i );
+    streamElement->SetAttribute( "offset", mesh->streams[i].offset );
+    streamElement->SetAttribute( "stride", mesh->streams[i].stride );
+    meshElement->InsertEndChild( streamElement );
+  }
+}
+
 //------------------------------------------------------------------------------------------------
 enum ChsShaderUniformDataType {
   CHS_SHADER_UNIFORM_1_FLOAT,
@@ -332,11 +587,12 @@ void getMaterialAttributeAtChannel( int channelIndex, MFnDependencyNode fnMateri
 }
 
 //--------------------------------------------------------------------------------------------------
-void makeMaterialAttribute( int channelIndex, XMLElement * materialElement ){
+void makeMaterialAttribute( int channelIndex, const ChsMeshMaterial & material, XMLElement * materialElement ){
   const MaterialChannel & materialChannel = materialChannels[channelIndex];
-  if( !materialChannel.textureFileName.empty() ){
+  const ChsMaterialChannelValue & channelValue = material.channels[channelIndex];
+  if( !channelValue.textureFileName.empty() ){
     XMLElement * textureElement = xmlFile.NewElement( "ChsTexture2D" );
-    textureElement->SetAttribute( "src", materialChannel.textureFileName.c_str() );
+    textureElement->SetAttribute( "src", channelValue.textureFileName.c_str() );
     MString sampleName = materialChannel.uniformName + "Texture";
     textureElement->SetAttribute( "sampleName", sampleName.asChar() );
     textureElement->SetAttribute( "activeUnit", materialChannel.activeUnit );
@@ -345,13 +601,14 @@ void makeMaterialAttribute( int channelIndex, XMLElement * materialElement ){
   else{
     MString colorName = materialChannel.uniformName + "Color";
     std::vector<float> rgb;
-    rgb += materialChannel.r, materialChannel.g, materialChannel.b, 1.0;
+    rgb += channelValue.r, channelValue.g, channelValue.b, 1.0;
     makePropertyElement( colorName, CHS_SHADER_UNIFORM_VEC4_FLOAT, 1, rgb, materialElement );
   }
 }
 
 //--------------------------------------------------------------------------------------------------
-void makeMaterialElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+void makeMaterialElement( ChsMeshSharedPtr & mesh, const ChsMeshMaterial & material, XMLElement * meshElement ){
+  bool hasTexture = !material.channels[DIFFUSE_COLOR].textureFileName.empty();
   XMLElement * materialElement = xmlFile.NewElement( "ChsMaterial" );
   meshElement->InsertEndChild( materialElement );
   XMLElement * shaderElement = xmlFile.NewElement( "ChsVertexShader" );
@@ -361,16 +618,21 @@ void makeMaterialElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
   shaderElement->SetAttribute( "src", "Shader.fsh" );
   materialElement->InsertEndChild( shaderElement );
   makePropertyElement( "hasVertexColor", CHS_SHADER_UNIFORM_1_INT, 1, mesh->hasVertexColor, materialElement );
-  makePropertyElement( "hasTexture", CHS_SHADER_UNIFORM_1_INT, 1, mesh->hasTexture, materialElement );
-  makeMaterialAttribute( DIFFUSE_COLOR, materialElement );
+  makePropertyElement( "hasTexture", CHS_SHADER_UNIFORM_1_INT, 1, hasTexture, materialElement );
+  makeMaterialAttribute( DIFFUSE_COLOR, material, materialElement );
 }
 
 //--------------------------------------------------------------------------------------------------
 void makeIndexBufferElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
   XMLElement * indexElement = xmlFile.NewElement( "ChsIndexBuffer" );
   indexElement->SetAttribute( "isShort" , mesh->isShort );
-  int count = mesh->isShort ? mesh->usIndexArray.size() : mesh->uiIndexArray.size();
+  indexElement->SetAttribute( "primitive" , "GL_TRIANGLES" );
+  int count = mesh->indexCount();
   indexElement->SetAttribute( "count" , count );
+  if( !mesh->encodedGeometry.empty() )
+    indexElement->SetAttribute( "encoding", CHS_ENCODING_GEOMETRY_CODEC );
+  else if( !mesh->encodedIndexArray.empty() )
+    indexElement->SetAttribute( "encoding", CHS_ENCODING_INDEX_CODEC );
   if( XML_FORMAT == format ){
     std::string textStr;
     if( mesh->isShort ){
@@ -391,15 +653,114 @@ void makeIndexBufferElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement )
   meshElement->InsertEndChild( indexElement );  
 }
 
+//--------------------------------------------------------------------------------------------------
+void makeSubmeshElements( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+  if( mesh->submeshes.size() < 2 && mesh->materials.size() < 2 )
+    return;
+  BOOST_FOREACH( const ChsSubmesh & submesh, mesh->submeshes ){
+    XMLElement * submeshElement = xmlFile.NewElement( "ChsSubmesh" );
+    submeshElement->SetAttribute( "firstVertex", submesh.firstVertex );
+    submeshElement->SetAttribute( "vertexCount", submesh.vertexCount );
+    submeshElement->SetAttribute( "firstIndex", submesh.firstIndex );
+    submeshElement->SetAttribute( "indexCount", submesh.indexCount );
+    submeshElement->SetAttribute( "material", submesh.material );
+    meshElement->InsertEndChild( submeshElement );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeMeshletBufferElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+  if( mesh->meshlets.empty() )
+    return;
+  XMLElement * meshletElement = xmlFile.NewElement( "ChsMeshletBuffer" );
+  meshletElement->SetAttribute( "count", static_cast<int>( mesh->meshlets.size() ) );
+  meshletElement->SetAttribute( "vertexCount", static_cast<int>( mesh->meshletVertices.size() ) );
+  meshletElement->SetAttribute( "triangleByteCount", static_cast<int>( mesh->meshletTriangles.size() ) );
+  meshletElement->SetAttribute( "maxVertices", exportOptions.meshletVertices );
+  meshletElement->SetAttribute( "maxTriangles", exportOptions.meshletTriangles );
+  meshElement->InsertEndChild( meshletElement );
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeLodElements( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+  BOOST_FOREACH( const ChsLod & lod, mesh->lods ){
+    XMLElement * lodElement = xmlFile.NewElement( "ChsLod" );
+    lodElement->SetAttribute( "ratio", lod.ratio );
+    lodElement->SetAttribute( "error", lod.error );
+    lodElement->SetAttribute( "count", static_cast<int>( lod.indices.size() ) );
+    if( !lod.encodedIndices.empty() )
+      lodElement->SetAttribute( "encoding", CHS_ENCODING_INDEX_CODEC );
+    if( lod.submeshes.size() > 1 ){
+      BOOST_FOREACH( const ChsSubmesh & submesh, lod.submeshes ){
+        XMLElement * submeshElement = xmlFile.NewElement( "ChsSubmesh" );
+        submeshElement->SetAttribute( "firstIndex", submesh.firstIndex );
+        submeshElement->SetAttribute( "indexCount", submesh.indexCount );
+        lodElement->InsertEndChild( submeshElement );
+      }
+    }
+    meshElement->InsertEndChild( lodElement );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeBatchRangeElements( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+  BOOST_FOREACH( const ChsBatchRange & range, mesh->batchRanges ){
+    XMLElement * rangeElement = xmlFile.NewElement( "ChsBatchRange" );
+    rangeElement->SetAttribute( "mesh", range.meshName.c_str() );
+    rangeElement->SetAttribute( "firstIndex", range.firstIndex );
+    rangeElement->SetAttribute( "indexCount", range.indexCount );
+    meshElement->InsertEndChild( rangeElement );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeDepthMeshElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
+  if( mesh->depthIndices.empty() )
+    return;
+  XMLElement * depthElement = xmlFile.NewElement( "ChsDepthMesh" );
+  depthElement->SetAttribute( "vertexCount", mesh->depthVertexCount() );
+  //the main stream position type, quantized positions share its positionScale and positionOffset
+  depthElement->SetAttribute( "positionType", chsAttributeTypeNames[mesh->attributes[0].type] );
+  depthElement->SetAttribute( "positionStride", mesh->depthPositionSize );
+  depthElement->SetAttribute( "count", static_cast<int>( mesh->depthIndices.size() ) );
+  depthElement->SetAttribute( "type", mesh->isDepthShort() ? "GL_UNSIGNED_SHORT" : "GL_UNSIGNED_INT" );
+  meshElement->InsertEndChild( depthElement );
+}
+
 //--------------------------------------------------------------------------------------------------
 void makeVertexBufferElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
   XMLElement * vertexElement = xmlFile.NewElement( "ChsVertexBuffer" );
-  int count = mesh->vertexArray.size();
-  vertexElement->SetAttribute( "count" , count );
+  vertexElement->SetAttribute( "vertexCount", mesh->vertexCount() );
+  vertexElement->SetAttribute( "vertexSize", mesh->vertexSize );
+  if( !mesh->encodedGeometry.empty() )
+    vertexElement->SetAttribute( "encoding", CHS_ENCODING_GEOMETRY_CODEC );
+  else if( !mesh->encodedVertexData.empty() )
+    vertexElement->SetAttribute( "encoding", CHS_ENCODING_VERTEX_CODEC );
+  if( mesh->isQuantized ){
+    std::string scaleStr, offsetStr;
+    for( int axis = 0; axis < 3; axis++ ){
+      scaleStr.append( boost::lexical_cast<std::string>( mesh->positionScale[axis] ) ).append( " " );
+      offsetStr.append( boost::lexical_cast<std::string>( mesh->positionOffset[axis] ) ).append( " " );
+    }
+    vertexElement->SetAttribute( "positionScale", scaleStr.c_str() );
+    vertexElement->SetAttribute( "positionOffset", offsetStr.c_str() );
+  }
+  else{
+    int count = mesh->vertexArray.size();
+    vertexElement->SetAttribute( "count" , count );
+  }
   if( XML_FORMAT == format ){
+    //anything but the plain interleaved float layout goes out as raw bytes
     std::string textStr;
-    BOOST_FOREACH( float & value , mesh->vertexArray ){
-      textStr.append( boost::lexical_cast<std::string>( value ) ).append( " " );
+    if( mesh->isQuantized || mesh->streams.size() > 1 ){
+      BOOST_FOREACH( unsigned char value , mesh->vertexData ){
+        textStr.append( boost::lexical_cast<std::string>( (int)value ) ).append( " " );
+      }
+    }
+    else{
+      BOOST_FOREACH( float & value , mesh->vertexArray ){
+        textStr.append( boost::lexical_cast<std::string>( value ) ).append( " " );
+      }
     }
     XMLText * text = xmlFile.NewText( textStr.c_str() );
     vertexElement->InsertEndChild( text );
@@ -451,116 +812,149 @@ void makeAnimCurveElement( ChsMeshSharedPtr & mesh, XMLElement * meshElement ){
 void makeXMLPart( const char * meshId, ChsMeshSharedPtr & mesh, XMLElement * modelElement ){
   XMLElement * meshElement = xmlFile.NewElement( "ChsMesh" );
   meshElement->SetAttribute( "id", meshId );
-  makeAttributeElement( POSITION, meshElement );
-  makeAttributeElement( NORMAL, meshElement );
-  if( mesh->hasUV && mesh->hasTexture ){
-    makeAttributeElement( TEXCOORD0, meshElement );
-  }
-  if( mesh->hasVertexColor ){
-    makeAttributeElement( COLOR, meshElement );
+  BOOST_FOREACH( const ChsVertexAttribute & attribute, mesh->attributes ){
+    makeAttributeElement( attribute, meshElement );
   }
+  makeVertexStreamElements( mesh, meshElement );
   makeVertexBufferElement( mesh, meshElement );
   makeIndexBufferElement( mesh, meshElement );
+  makeSubmeshElements( mesh, meshElement );
+  makeBatchRangeElements( mesh, meshElement );
+  makeMeshletBufferElement( mesh, meshElement );
+  makeLodElements( mesh, meshElement );
+  makeDepthMeshElement( mesh, meshElement );
   makeTransformElement( mesh, meshElement );
   if( mesh->isAnimated ){
     makeAnimCurveElement( mesh, meshElement );
   }
-  makeMaterialElement( mesh, meshElement );
+  BOOST_FOREACH( const ChsMeshMaterial & material, mesh->materials ){
+    makeMaterialElement( mesh, material, meshElement );
+  }
   modelElement->InsertEndChild( meshElement );
 }
 
 //--------------------------------------------------------------------------------------------------
-struct VertexUnit{
-  int vertexId;
-  int uvId;
-};
-
-std::vector< VertexUnit > vertexList;
+static ChsMeshData meshData;
 //--------------------------------------------------------------------------------------------------
-void getIndexData( const MFnMesh & fnMesh, ChsMeshSharedPtr & mesh ){
-  int numPolygons = fnMesh.numPolygons();
-  mesh->isShort = ( numPolygons * 3 < USHRT_MAX );
-  vertexList.clear();
+void gatherMeshData( const MFnMesh & fnMesh, ChsMeshData & data ){
+  data.clear();
+  MFloatPointArray points;
+  fnMesh.getPoints( points, MSpace::kObject );
+  int numVertices = points.length();
+  data.points.resize( numVertices * 3 );
+  for( int i = 0; i < numVertices; i++ ){
+    const MFloatPoint & pos = points[i];
+    float w = pos.w != 0.0f ? pos.w : 1.0f;
+    data.points[i * 3] = pos.x / w;
+    data.points[i * 3 + 1] = pos.y / w;
+    data.points[i * 3 + 2] = pos.z / w;
+  }
+  MFloatVectorArray normals;
+  fnMesh.getNormals( normals, MSpace::kObject );
+  int numNormals = normals.length();
+  data.normals.resize( numNormals * 3 );
+  normals.get( (float (*)[3])data.normals.data() );
   
-  for( int polygonId = 0; polygonId < numPolygons; polygonId++ ){
-    MIntArray vertexListOfPolygon;
-    fnMesh.getPolygonVertices( polygonId, vertexListOfPolygon );
-    int vertexCountOfPolygon = vertexListOfPolygon.length();
-    for( int vertexIndex = 0; vertexIndex < vertexCountOfPolygon; vertexIndex++ ){
-      int vertexId = vertexListOfPolygon[vertexIndex];
-      int uvId;
-      fnMesh.getPolygonUVid( polygonId, vertexIndex, uvId );
-
-      int index = -1;
-      int indexCount = 0;
-      BOOST_FOREACH( VertexUnit & unit, vertexList ){
-        if( unit.uvId == uvId && unit.vertexId == vertexId ){
-          index = indexCount;
-          break;
-        }
-        indexCount++;
-      }
-      if( index == -1 ){
-        index = vertexList.size();
-        VertexUnit unit = { vertexId, uvId };
-        vertexList += unit;
+  MIntArray polygonCounts, vertexIds;
+  fnMesh.getVertices( polygonCounts, vertexIds );
+  int numPolygons = polygonCounts.length();
+  int numFaceVertices = vertexIds.length();
+  data.polygonCounts.resize( numPolygons );
+  polygonCounts.get( data.polygonCounts.data() );
+  data.vertexIds.resize( numFaceVertices );
+  vertexIds.get( data.vertexIds.data() );
+  
+  MIntArray normalCounts, normalIds;
+  fnMesh.getNormalIds( normalCounts, normalIds );
+  data.normalIds.resize( normalIds.length() );
+  normalIds.get( data.normalIds.data() );
+  
+  if( fnMesh.numUVs() > 0 ){
+    MFloatArray uArray, vArray;
+    fnMesh.getUVs( uArray, vArray );
+    int numUVs = uArray.length();
+    data.uvs.resize( numUVs * 2 );
+    for( int i = 0; i < numUVs; i++ ){
+      data.uvs[i * 2] = uArray[i];
+      data.uvs[i * 2 + 1] = vArray[i];
+    }
+    //polygons without uv report a zero count, expand to one id per face-vertex
+    MIntArray uvCounts, uvIds;
+    fnMesh.getAssignedUVs( uvCounts, uvIds );
+    data.uvIds.assign( numFaceVertices, -1 );
+    int faceVertex = 0, uvIndex = 0;
+    for( int polygonId = 0; polygonId < numPolygons; polygonId++ ){
+      if( uvCounts[polygonId] > 0 ){
+        for( int i = 0; i < polygonCounts[polygonId]; i++ )
+          data.uvIds[faceVertex + i] = uvIds[uvIndex++];
       }
-      mesh->addIndexValue( index );
+      faceVertex += polygonCounts[polygonId];
     }
   }
-}
-
-//--------------------------------------------------------------------------------------------------
-void getVertexData( MFnMesh & fnMesh, ChsMeshSharedPtr & mesh ){
-  //check uv
-  mesh->hasUV = fnMesh.numUVs() > 0;
-  MFloatArray uArray, vArray;
-  if( mesh->hasUV && mesh->hasTexture ){
-    fnMesh.getUVs( uArray, vArray );
+  else{
+    data.uvIds.assign( numFaceVertices, -1 );
   }
-  //check vertex color
-  mesh->hasVertexColor = fnMesh.numColors() > 0;
-  MColorArray colors;
-  if( mesh->hasVertexColor ){
+  
+  if( fnMesh.numColors() > 0 ){
+    MColorArray colors;
     fnMesh.getVertexColors( colors );
+    int numColors = colors.length();
+    data.colors.resize( numColors * 4 );
+    colors.get( (float (*)[4])data.colors.data() );
   }
-  BOOST_FOREACH( VertexUnit & unit, vertexList ){
-    int vertexId = unit.vertexId;
-    int uvId = unit.uvId;
-    MPoint pos;
-    MVector normal;
-    fnMesh.getPoint( vertexId, pos, MSpace::kObject );
-    pos.cartesianize();
-    mesh->addPosition( pos );
-    fnMesh.getVertexNormal( vertexId, true, normal, MSpace::kObject );
-    mesh->addNormal( normal );
-    if( mesh->hasUV && mesh->hasTexture ){
-      mesh->addUV( uArray[uvId], vArray[uvId] );
-    }
-    if( mesh->hasVertexColor ){
-      mesh->addColor( colors[vertexId] );
-    }
-  }
+  
+  MIntArray triangleCounts, triangleVertices;
+  fnMesh.getTriangles( triangleCounts, triangleVertices );
+  data.triangleCounts.resize( triangleCounts.length() );
+  triangleCounts.get( data.triangleCounts.data() );
+  data.triangleVertices.resize( triangleVertices.length() );
+  triangleVertices.get( data.triangleVertices.data() );
 }
 
 //--------------------------------------------------------------------------------------------------
-void makeBinaryPart( MFnMesh & fnMesh, ChsMeshSharedPtr & mesh ){
-  getIndexData( fnMesh, mesh );
-  getVertexData( fnMesh, mesh );
+void readMaterial( const MObject & shader, ChsMeshMaterial & material ){
+  MFnDependencyNode fnShader( shader );
+  MPlug surfaceShader = fnShader.findPlug("surfaceShader");
+  MPlugArray materials;
+  surfaceShader.connectedTo( materials, true, true);
+  MaterialChannel & diffuseChannel = materialChannels[DIFFUSE_COLOR];
+  diffuseChannel.textureFileName.clear();
+  diffuseChannel.r = diffuseChannel.g = diffuseChannel.b = 1.0;
+  if( materials.length() > 0 ){
+    MObject materialNode = materials[0].node();
+    getMaterialAttributeAtChannel( DIFFUSE_COLOR, materialNode );
+  }
+  material.channels.clear();
+  BOOST_FOREACH( const MaterialChannel & materialChannel, materialChannels ){
+    ChsMaterialChannelValue value = { materialChannel.textureFileName, materialChannel.r, materialChannel.g, materialChannel.b };
+    material.channels += value;
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
-void processMaterial( MFnMesh & fnMesh, ChsMeshSharedPtr & mesh ){
+//	one ChsMeshMaterial per connected shading group, faces without one use the first
+//--------------------------------------------------------------------------------------------------
+void processMaterial( MFnMesh & fnMesh, ChsMeshSharedPtr & mesh, ChsMeshData & data ){
   MObjectArray shaders;
   MIntArray faceIndices;
   fnMesh.getConnectedShaders( 0, shaders, faceIndices );
-  MFnDependencyNode fnShader( shaders[0]);
-  MPlug surfaceShader = fnShader.findPlug("surfaceShader");
-  MPlugArray materials;
-  surfaceShader.connectedTo( materials, true, true);
-  MObject materialNode = materials[0].node();
-  getMaterialAttributeAtChannel( DIFFUSE_COLOR, materialNode );
-  mesh->hasTexture = materialChannels[DIFFUSE_COLOR].textureFileName.empty() ? false : true;
+  int shaderCount = shaders.length();
+  mesh->materials.resize( shaderCount > 0 ? shaderCount : 1 );
+  mesh->hasTexture = false;
+  for( int shaderIdx = 0; shaderIdx < shaderCount; shaderIdx++ ){
+    readMaterial( shaders[shaderIdx], mesh->materials[shaderIdx] );
+  }
+  if( shaderCount == 0 ){
+    readMaterial( MObject(), mesh->materials[0] );
+  }
+  BOOST_FOREACH( const ChsMeshMaterial & material, mesh->materials ){
+    mesh->hasTexture |= !material.channels[DIFFUSE_COLOR].textureFileName.empty();
+  }
+  int numPolygons = faceIndices.length();
+  data.polygonMaterials.resize( numPolygons );
+  for( int polygonId = 0; polygonId < numPolygons; polygonId++ ){
+    data.polygonMaterials[polygonId] = faceIndices[polygonId] >= 0 ? faceIndices[polygonId] : 0;
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -646,6 +1040,9 @@ void processAnimCurve( MDagPath & dagPath ){
 
 }
 
+//--------------------------------------------------------------------------------------------------
+void processMeshList( bool isLast );
+
 //--------------------------------------------------------------------------------------------------
 void processMesh( MDagPath & dagPath ){
   MStatus status;
@@ -654,13 +1051,24 @@ void processMesh( MDagPath & dagPath ){
     if( !fnMesh.isIntermediateObject() ){
       MGlobal::displayInfo( "mesh" );
       ChsMeshSharedPtr mesh( new ChsMesh );
-      processMaterial( fnMesh, mesh );
+      mesh->name = fnMesh.name().asChar();
+      if( exportOptions.batchStaticMeshes )
+        mesh->hasAnimatedTransform = MAnimUtil::isAnimated( dagPath, true );
       processMeshTransform( dagPath, mesh );
-
-      makeBinaryPart( fnMesh, mesh );
-      makeXMLPart( fnMesh.name().asChar(), mesh, modelElement );
+      gatherMeshData( fnMesh, meshData );
+      processMaterial( fnMesh, mesh, meshData );
+      int fannedCount = buildMesh( meshData, mesh );
+      if( fannedCount > 0 ){
+        MString warning = fnMesh.name() + ": ";
+        warning += fannedCount;
+        warning += " polygons do not match their triangulation, fanned instead";
+        MGlobal::displayWarning( warning );
+      }
       
       meshList.push_back( mesh );
+      //streaming holds one mesh per worker
+      if( streamWriter && (int)meshList.size() >= streamWindowSize() )
+        processMeshList( false );
     }
   }
 }
@@ -679,6 +1087,118 @@ MStatus processNode( MDagPath & dagPath ){
   return MStatus::kSuccess;
 }
 
+//--------------------------------------------------------------------------------------------------
+struct MeshPipelineJob{
+  std::vector<ChsMeshReport> reports;
+  void operator()( int meshIdx ){
+    runMeshPipeline( meshList[meshIdx], exportOptions, reports[meshIdx] );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+void logMeshReport( const ChsMeshSharedPtr & mesh, const ChsMeshReport & report ){
+  MString info = mesh->name.c_str();
+  if( report.isSplit ){
+    info += ": split into ";
+    info += (int)mesh->submeshes.size();
+    info += " submeshes";
+  }
+  info += ": vertex cache acmr ";
+  info += report.cacheBefore.acmr;
+  info += " -> ";
+  info += report.cacheAfter.acmr;
+  info += ", atvr ";
+  info += report.cacheBefore.atvr;
+  info += " -> ";
+  info += report.cacheAfter.atvr;
+  if( report.hasOverdraw ){
+    info += ", overdraw ";
+    info += report.overdrawBefore.overdraw;
+    info += " -> ";
+    info += report.overdrawAfter.overdraw;
+  }
+  info += ", vertex ";
+  info += mesh->vertexSize;
+  info += " bytes";
+  if( !mesh->encodedGeometry.empty() ){
+    int rawSize = mesh->vertexData.size() + mesh->indexCount() * ( mesh->isShort ? 2 : 4 );
+    info += ", geometry ";
+    info += rawSize;
+    info += " -> ";
+    info += (int)mesh->encodedGeometry.size();
+    info += " bytes, ";
+    info += (float)mesh->encodedGeometry.size() * 8.0f / mesh->vertexCount();
+    info += " bits per vertex";
+  }
+  if( !mesh->encodedVertexData.empty() ){
+    info += ", vertex block ";
+    info += (int)mesh->vertexData.size();
+    info += " -> ";
+    info += (int)mesh->encodedVertexData.size();
+    info += " filtered bytes";
+  }
+  if( !mesh->encodedIndexArray.empty() ){
+    info += ", index ";
+    info += mesh->indexCount() * ( mesh->isShort ? 2 : 4 );
+    info += " -> ";
+    info += (int)mesh->encodedIndexArray.size();
+    info += " bytes";
+  }
+  if( !mesh->depthIndices.empty() ){
+    int depthSize = mesh->depthPositions.size() + mesh->depthIndices.size() * ( mesh->isDepthShort() ? 2 : 4 );
+    info += ", depth mesh ";
+    info += mesh->depthVertexCount();
+    info += " of ";
+    info += mesh->vertexCount();
+    info += " vertices, ";
+    info += depthSize;
+    info += " bytes";
+  }
+  BOOST_FOREACH( const ChsLod & lod, mesh->lods ){
+    info += ", lod ";
+    info += lod.ratio;
+    info += ": ";
+    info += (int)lod.indices.size() / 3;
+    info += " triangles, error ";
+    info += lod.error;
+  }
+  MGlobal::displayInfo( info );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Maya is only touched while gathering, everything after runs on all cores
+//--------------------------------------------------------------------------------------------------
+void processMeshList( bool isLast ){
+  if( exportOptions.batchStaticMeshes ){
+    batchStaticMeshes( meshList, batchState, isLast, exportOptions.buildTangents );
+    if( isLast ){
+      MString info = "static batching: ";
+      info += batchState.batchedCount;
+      info += " meshes into ";
+      info += batchState.batchCount;
+      info += " batches";
+      MGlobal::displayInfo( info );
+    }
+  }
+  MeshPipelineJob job;
+  job.reports.resize( meshList.size() );
+  parallelFor( meshList.size(), job );
+  int firstMeshIdx = exportedMeshCount;
+  //the window's meshes go through the pipeline at once, next to the batches still filling up
+  size_t heldBytes = 0;
+  for( size_t meshIdx = 0; meshIdx < meshList.size(); meshIdx++ ){
+    ChsMeshSharedPtr & mesh = meshList[meshIdx];
+    logMeshReport( mesh, job.reports[meshIdx] );
+    makeXMLPart( mesh->name.c_str(), mesh, modelElement );
+    exportedMeshCount++;
+    heldBytes += job.reports[meshIdx].peakBytes;
+  }
+  BOOST_FOREACH( const ChsOpenBatch & open, batchState.openBatches )
+    heldBytes += open.mesh->memorySize() + open.indices.size() * sizeof( unsigned int );
+  if( streamWriter )
+    streamMeshList( firstMeshIdx, heldBytes );
+}
+
 //--------------------------------------------------------------------------------------------------
 MStatus prepareXMLWithAll( void ){
   MGlobal::displayInfo("prepareXMLWithAll");
@@ -711,9 +1231,196 @@ MStatus prepareXMLWithSelection( void ){
 }
 
 //--------------------------------------------------------------------------------------------------
-MStatus ChaosExport::writer( const MFileObject &file,	const MString &/*options*/,	FileAccessMode mode ){
+//	Import: every ChsMesh becomes a triangle mesh under a transform of its name, vertices stay split
+//	the way the exporter split them, so seams come back as open edges. Indices are copied out, a plain
+//	version 1 block sits wherever the size prefixes put it, not aligned for its index type
+//--------------------------------------------------------------------------------------------------
+static unsigned int readIndex( const ChsBufferView & indices, bool isShort, int position ){
+  const unsigned char * source = static_cast<const unsigned char *>( indices.data );
+  if( isShort ){
+    unsigned short index;
+    memcpy( &index, source + (size_t)position * sizeof( index ), sizeof( index ) );
+    return index;
+  }
+  unsigned int index;
+  memcpy( &index, source + (size_t)position * sizeof( index ), sizeof( index ) );
+  return index;
+}
+
+//--------------------------------------------------------------------------------------------------
+MStatus importMesh( ChsModelReader & model, int meshIdx ){
+  const ChsModelMesh & mesh = model.mesh( meshIdx );
+  ChsBufferView vertices, indices;
+  std::vector<float> positions, normals, texcoords, colors;
+  if( !model.vertices( meshIdx, vertices ) || !model.indices( meshIdx, indices ) ||
+      !readVertexAttribute( mesh, vertices, CHS_ATTRIBUTE_POSITION, positions, 3 ) ){
+    MGlobal::displayError( MString( mesh.id.c_str() ) + ": buffers do not decode" );
+    return MStatus::kFailure;
+  }
+  MFloatPointArray points;
+  points.setLength( mesh.vertexCount );
+  for( int i = 0; i < mesh.vertexCount; i++ )
+    points.set( MFloatPoint( positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2] ), i );
+  MIntArray polygonCounts, polygonConnects;
+  BOOST_FOREACH( const ChsSubmesh & submesh, mesh.submeshes ){
+    for( int i = 0; i < submesh.indexCount; i++ ){
+      unsigned int index = submesh.firstVertex + readIndex( indices, mesh.isShort, submesh.firstIndex + i );
+      if( index >= (unsigned int)mesh.vertexCount ){
+        MGlobal::displayError( MString( mesh.id.c_str() ) + ": index out of range" );
+        return MStatus::kFailure;
+      }
+      polygonConnects.append( index );
+    }
+  }
+  int triangleCount = polygonConnects.length() / 3;
+  for( int i = 0; i < triangleCount; i++ )
+    polygonCounts.append( 3 );
+  MFloatArray uArray, vArray;
+  bool hasUV = readVertexAttribute( mesh, vertices, CHS_ATTRIBUTE_TEXCOORD0, texcoords, 2 );
+  for( int i = 0; hasUV && i < mesh.vertexCount; i++ ){
+    uArray.append( texcoords[i * 2] );
+    vArray.append( texcoords[i * 2 + 1] );
+  }
+  MFnMesh fnMesh;
+  MStatus status;
+  MObject transform = fnMesh.create( mesh.vertexCount, triangleCount, points, polygonCounts, polygonConnects,
+                                     uArray, vArray, MObject::kNullObj, &status );
+  if( !status )
+    return status;
+  if( hasUV )
+    fnMesh.assignUVs( polygonCounts, polygonConnects );
+  if( readVertexAttribute( mesh, vertices, CHS_ATTRIBUTE_NORMAL, normals, 3 ) ){
+    MVectorArray faceNormals;
+    MIntArray faces;
+    for( unsigned int i = 0; i < polygonConnects.length(); i++ ){
+      int vertex = polygonConnects[i];
+      faceNormals.append( MVector( normals[vertex * 3], normals[vertex * 3 + 1], normals[vertex * 3 + 2] ) );
+      faces.append( i / 3 );
+    }
+    fnMesh.setFaceVertexNormals( faceNormals, faces, polygonConnects );
+  }
+  if( readVertexAttribute( mesh, vertices, CHS_ATTRIBUTE_COLOR, colors, 4 ) ){
+    MColorArray vertexColors;
+    MIntArray vertexList;
+    for( int i = 0; i < mesh.vertexCount; i++ ){
+      vertexColors.append( MColor( colors[i * 4], colors[i * 4 + 1], colors[i * 4 + 2], colors[i * 4 + 3] ) );
+      vertexList.append( i );
+    }
+    fnMesh.setVertexColors( vertexColors, vertexList );
+  }
+  double matrix[4][4];
+  for( int i = 0; i < 4; i++ ){
+    for( int j = 0; j < 4; j++ )
+      matrix[i][j] = mesh.transform[i][j];
+  }
+  MFnTransform fnTransform( transform );
+  fnTransform.set( MTransformationMatrix( MMatrix( matrix ) ) );
+  if( !mesh.id.empty() )
+    fnTransform.setName( mesh.id.c_str() );
+  return MStatus::kSuccess;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the engine loader as it is: every block read into a buffer of its own
+//--------------------------------------------------------------------------------------------------
+static size_t loadWithStream( const char * fileName ){
+  std::ifstream file( fileName, std::ios::binary );
+  char magic[4];
+  int sizeOfXML;
+  if( !file.read( magic, 4 ) || !file.read( reinterpret_cast<char *>( &sizeOfXML ), sizeof( int ) ) )
+    return 0;
+  size_t bytes = 0;
+  if( sizeOfXML == CHS_MODEL_VERSION ){
+    //version 2, every chunk from its table of contents entry
+    ChsModelHeader header;
+    file.seekg( 0 );
+    file.read( reinterpret_cast<char *>( &header ), sizeof( header ) );
+    std::vector<ChsChunkEntry> entries( header.chunkCount );
+    file.seekg( header.tocOffset );
+    file.read( reinterpret_cast<char *>( entries.data() ), entries.size() * sizeof( ChsChunkEntry ) );
+    BOOST_FOREACH( const ChsChunkEntry & entry, entries ){
+      std::vector<char> chunk( entry.size );
+      file.seekg( entry.offset );
+      file.read( chunk.data(), chunk.size() );
+      bytes += file.gcount();
+    }
+    return bytes;
+  }
+  std::vector<char> xml( sizeOfXML );
+  file.read( xml.data(), xml.size() );
+  bytes += file.gcount();
+  int sizeOfBlock;
+  while( file.read( reinterpret_cast<char *>( &sizeOfBlock ), sizeof( int ) ) && sizeOfBlock >= 0 ){
+    std::vector<char> block( sizeOfBlock );
+    file.read( block.data(), sizeOfBlock );
+    bytes += file.gcount();
+  }
+  return bytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	a renderer reads every page of the views once, the sum stands in for the upload
+//--------------------------------------------------------------------------------------------------
+static unsigned int pageSum = 0;
+
+static size_t loadWithMapping( const char * fileName ){
+  ChsModelReader model;
+  if( !model.open( fileName ) )
+    return 0;
+  size_t bytes = 0;
+  for( int meshIdx = 0; meshIdx < model.meshCount(); meshIdx++ ){
+    std::vector<ChsBufferView> views( 2 );
+    model.vertices( meshIdx, views[0] );
+    model.indices( meshIdx, views[1] );
+    for( size_t level = 1; level <= model.mesh( meshIdx ).lods.size(); level++ ){
+      views.push_back( ChsBufferView() );
+      model.lodIndices( meshIdx, level, views.back() );
+    }
+    BOOST_FOREACH( const ChsBufferView & view, views ){
+      const unsigned char * data = static_cast<const unsigned char *>( view.data );
+      for( size_t i = 0; data != NULL && i < view.size; i += 4096 )
+        pageSum += data[i];
+      bytes += data != NULL ? view.size : 0;
+    }
+  }
+  return bytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+static void benchmarkLoad( const MString & fullFileName ){
+  const int runs = 5;
+  double streamTime = 1e30, mappedTime = 1e30;
+  size_t streamBytes = 0, mappedBytes = 0;
+  for( int run = 0; run < runs; run++ ){
+    boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+    streamBytes = loadWithStream( fullFileName.asChar() );
+    boost::posix_time::ptime middleTime = boost::posix_time::microsec_clock::universal_time();
+    mappedBytes = loadWithMapping( fullFileName.asChar() );
+    boost::posix_time::ptime endTime = boost::posix_time::microsec_clock::universal_time();
+    streamTime = std::min( streamTime, ( middleTime - startTime ).total_microseconds() * 1e-3 );
+    mappedTime = std::min( mappedTime, ( endTime - middleTime ).total_microseconds() * 1e-3 );
+  }
+  MString info = "load benchmark, best of ";
+  info += runs;
+  info += ": ifstream ";
+  info += streamTime;
+  info += " ms for ";
+  info += (double)streamBytes;
+  info += " bytes, mapped ";
+  info += mappedTime;
+  info += " ms for ";
+  info += (double)mappedBytes;
+  info += " bytes";
+  MGlobal::displayInfo( info );
+}
+
+//--------------------------------------------------------------------------------------------------
+MStatus ChaosExport::writer( const MFileObject &file,	const MString &options,	FileAccessMode mode ){
   meshList.clear();
+  exportedMeshCount = 0;
+  batchState = ChsBatchState();
   format = BINARY_FORMAT;
+  parseExportOptions( options.asChar(), exportOptions );
   
   bool isExportSelection;
   MStatus status;
@@ -732,14 +1439,23 @@ MStatus ChaosExport::writer( const MFileObject &file,	const MString &/*options*/
 #endif
   
   initXMLFile();
+  if( BINARY_FORMAT == format && exportOptions.containerVersion >= 2 ){
+    //meshes go out while the scene is walked
+    status = beginStream( fullFileName );
+    if( !status )
+      return status;
+  }
   
   if( MStatus::kSuccess == (isExportSelection ? prepareXMLWithSelection() : prepareXMLWithAll()) ){
+    processMeshList( true );
     MGlobal::displayInfo("writeToFile");
-    modelElement->SetAttribute( "meshCount", static_cast<int>( meshList.size() ) );
+    modelElement->SetAttribute( "meshCount", exportedMeshCount );
     MString modelId = shortFileName.substring( 0, shortFileName.length()-extension.length()-2 );
     modelElement->SetAttribute( "id", modelId.asChar() );
-    status = writeToFile( fullFileName );
+    status = streamWriter ? finishStream( fullFileName ) : writeToFile( fullFileName );
   }
+  //a failed walk leaves the stream open
+  abortStream();
 
   if( MStatus::kSuccess == status ){
     MGlobal::displayInfo("Export to " + fullFileName + " successful!");
@@ -750,6 +1466,56 @@ MStatus ChaosExport::writer( const MFileObject &file,	const MString &/*options*/
 	return status;
 }
 
+//--------------------------------------------------------------------------------------------------
+MStatus ChaosExport::reader( const MFileObject & file, const MString & options, FileAccessMode ){
+  ChsExportOptions importOptions;
+  parseExportOptions( options.asChar(), importOptions );
+#if defined( OSMac_ )
+  char nameBuffer[ MAXPATHLEN ];
+  strcpy( nameBuffer, file.fullName().asChar() );
+  const MString fullFileName( nameBuffer );
+#else
+  const MString fullFileName = file.fullName();
+#endif
+  boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+  ChsModelReader model;
+  if( !model.open( fullFileName.asChar() ) ){
+    MGlobal::displayError( fullFileName + ": not a binary chsmodel or damaged" );
+    return MStatus::kFailure;
+  }
+  std::vector<int> meshIndices;
+  for( size_t i = 0; i < importOptions.importMeshIds.size(); i++ ){
+    const ChsMeshDirectoryEntry * entry = model.findMesh( importOptions.importMeshIds[i].c_str() );
+    if( entry == NULL ){
+      MGlobal::displayError( fullFileName + ": no mesh " + importOptions.importMeshIds[i].c_str() );
+      return MStatus::kFailure;
+    }
+    meshIndices.push_back( entry->mesh );
+  }
+  if( importOptions.importMeshIds.empty() ){
+    for( int meshIdx = 0; meshIdx < model.meshCount(); meshIdx++ )
+      meshIndices.push_back( meshIdx );
+  }
+  for( size_t i = 0; i < meshIndices.size(); i++ ){
+    MStatus status = importMesh( model, meshIndices[i] );
+    if( !status )
+      return status;
+  }
+  boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - startTime;
+  MString info = "imported ";
+  info += (int)meshIndices.size();
+  info += " meshes from chsmodel v";
+  info += model.version();
+  info += " in ";
+  info += elapsed.total_microseconds() * 1e-3;
+  info += " ms";
+  MGlobal::displayInfo( info );
+  model.close();
+  if( importOptions.runBenchmarks )
+    benchmarkLoad( fullFileName );
+  return MStatus::kSuccess;
+}
+
 //--------------------------------------------------------------------------------------------------
 MPxFileTranslator::MFileKind ChaosExport::identifyFile( const MFileObject &file, const char * , short )const{
   MString name = file.name();
@@ -9,6 +9,7 @@ public:
 	ChaosExport( void ){}
 	~ChaosExport( void ){}
 	MStatus writer( const MFileObject &file, const MString &optionsString, FileAccessMode mode );
+  MStatus reader( const MFileObject &file, const MString &optionsString, FileAccessMode mode );
 	inline bool haveWriteMethod( void )const;
   inline bool haveReadMethod( void )const;
   bool canBeOpened( void ) const;
@@ -24,7 +25,7 @@ inline bool ChaosExport::haveWriteMethod( void ) const{
 
 //--------------------------------------------------------------------------------------------------
 inline bool ChaosExport::haveReadMethod( void )const{
-  return false;
+  return true;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -0,0 +1,90 @@
+#include <string.h>
+
+#include "ChsChunkCompressor.h"
+#include "ChsLz4.h"
+#include "ChsParallel.h"
+
+//--------------------------------------------------------------------------------------------------
+struct CompressChunkJob{
+  const unsigned char * data;
+  size_t size;
+  size_t chunkSize;
+  std::vector< std::vector<unsigned char> > chunks;
+  void operator()( int chunkIdx ){
+    size_t offset = chunkIdx * chunkSize;
+    size_t length = size - offset < chunkSize ? size - offset : chunkSize;
+    std::vector<unsigned char> & chunk = chunks[chunkIdx];
+    chunk.resize( lz4CompressBound( length ) );
+    size_t compressedSize = lz4Compress( chunk.data(), chunk.size(), data + offset, length );
+    if( compressedSize == 0 || compressedSize >= length )
+      chunk.assign( data + offset, data + offset + length );
+    else
+      chunk.resize( compressedSize );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+void compressChunks( const unsigned char * data, size_t size, size_t chunkSize,
+                     std::vector<ChsCompressedChunk> & table, std::vector<unsigned char> & compressed ){
+  int chunkCount = ( size + chunkSize - 1 ) / chunkSize;
+  CompressChunkJob job;
+  job.data = data;
+  job.size = size;
+  job.chunkSize = chunkSize;
+  job.chunks.resize( chunkCount );
+  parallelFor( chunkCount, job );
+  table.resize( chunkCount );
+  compressed.clear();
+  for( int chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++ ){
+    const std::vector<unsigned char> & chunk = job.chunks[chunkIdx];
+    table[chunkIdx].compressedSize = chunk.size();
+    table[chunkIdx].uncompressedSize = size - chunkIdx * chunkSize < chunkSize ? size - chunkIdx * chunkSize : chunkSize;
+    compressed.insert( compressed.end(), chunk.begin(), chunk.end() );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+struct DecompressChunkJob{
+  unsigned char * destination;
+  const ChsCompressedChunk * table;
+  const unsigned char * compressed;
+  std::vector<size_t> sourceOffsets;
+  std::vector<size_t> destinationOffsets;
+  bool failed;
+  void operator()( int chunkIdx ){
+    const ChsCompressedChunk & chunk = table[chunkIdx];
+    unsigned char * output = destination + destinationOffsets[chunkIdx];
+    const unsigned char * input = compressed + sourceOffsets[chunkIdx];
+    if( chunk.compressedSize == chunk.uncompressedSize )
+      memcpy( output, input, chunk.uncompressedSize );
+    else if( lz4Decompress( output, chunk.uncompressedSize, input, chunk.compressedSize ) != (int)chunk.uncompressedSize )
+      failed = true;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+bool decompressChunks( unsigned char * destination, size_t size, const ChsCompressedChunk * table, int chunkCount,
+                       const unsigned char * compressed, size_t compressedSize ){
+  DecompressChunkJob job;
+  job.destination = destination;
+  job.table = table;
+  job.compressed = compressed;
+  job.failed = false;
+  job.sourceOffsets.resize( chunkCount );
+  job.destinationOffsets.resize( chunkCount );
+  size_t sourceOffset = 0, destinationOffset = 0;
+  for( int chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++ ){
+    job.sourceOffsets[chunkIdx] = sourceOffset;
+    job.destinationOffsets[chunkIdx] = destinationOffset;
+    sourceOffset += table[chunkIdx].compressedSize;
+    destinationOffset += table[chunkIdx].uncompressedSize;
+    if( sourceOffset > compressedSize || destinationOffset > size )
+      return false;
+  }
+  if( sourceOffset != compressedSize || destinationOffset != size )
+    return false;
+  parallelFor( chunkCount, job );
+  return !job.failed;
+}
+
+//--------------------------------------------------------------------------------------------------
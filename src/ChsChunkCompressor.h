@@ -0,0 +1,32 @@
+#ifndef _CHSCHUNKCOMPRESSOR_H
+#define _CHSCHUNKCOMPRESSOR_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//	A payload cut into fixed size chunks, each LZ4 compressed on its own so both sides can work on
+//	all cores. The table gives every chunk's sizes, a chunk's data starts where the previous one
+//	ends and decompresses to chunk index * chunkSize in the payload. A chunk LZ4 can not shrink is
+//	stored as is, with compressedSize equal to uncompressedSize.
+//--------------------------------------------------------------------------------------------------
+enum{
+  CHS_DEFAULT_CHUNK_SIZE = 256 * 1024,
+  CHS_MAX_CHUNK_SIZE = 64 * 1024 * 1024,
+};
+
+struct ChsCompressedChunk{
+  unsigned int compressedSize;
+  unsigned int uncompressedSize;
+};
+
+//--------------------------------------------------------------------------------------------------
+void compressChunks( const unsigned char * data, size_t size, size_t chunkSize,
+                     std::vector<ChsCompressedChunk> & table, std::vector<unsigned char> & compressed );
+//destination holds the whole payload, returns false on malformed input
+bool decompressChunks( unsigned char * destination, size_t size, const ChsCompressedChunk * table, int chunkCount,
+                       const unsigned char * compressed, size_t compressedSize );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSCHUNKCOMPRESSOR_H
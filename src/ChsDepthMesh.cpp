@@ -0,0 +1,64 @@
+#include <string.h>
+#include <vector>
+
+#include "ChsDepthMesh.h"
+#include "ChsMeshOptimizer.h"
+#include "ChsVertexWelder.h"
+
+//--------------------------------------------------------------------------------------------------
+//	stored bits zero padded, so only bitwise equal positions are welded
+//--------------------------------------------------------------------------------------------------
+struct PositionUnit{
+  int words[3];
+};
+
+//--------------------------------------------------------------------------------------------------
+void buildDepthMesh( ChsMeshSharedPtr & mesh, const unsigned char * positions, int positionStride,
+                     int positionSize ){
+  mesh->depthPositions.clear();
+  mesh->depthIndices.clear();
+  //4 byte aligned like the main stream attributes
+  mesh->depthPositionSize = ( positionSize + 3 ) & ~3;
+  int vertexCount = mesh->vertexCount();
+  ChsVertexWelder< PositionUnit > welder;
+  welder.reset( vertexCount );
+  std::vector<unsigned int> positionIndices( vertexCount );
+  for( int i = 0; i < vertexCount; i++ ){
+    PositionUnit unit = { { 0, 0, 0 } };
+    memcpy( &unit, positions + (size_t)i * positionStride, positionSize );
+    positionIndices[i] = welder.weld( unit );
+  }
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  mesh->depthIndices.reserve( indices.size() );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    for( int k = 0; k < submesh.indexCount; k += 3 ){
+      const unsigned int * triangle = &indices[submesh.firstIndex + k];
+      unsigned int a = positionIndices[submesh.firstVertex + triangle[0]];
+      unsigned int b = positionIndices[submesh.firstVertex + triangle[1]];
+      unsigned int c = positionIndices[submesh.firstVertex + triangle[2]];
+      //triangles that only differed by a seam collapse, drop them
+      if( a == b || b == c || c == a )
+        continue;
+      mesh->depthIndices.push_back( a );
+      mesh->depthIndices.push_back( b );
+      mesh->depthIndices.push_back( c );
+    }
+  }
+  int positionCount = welder.count();
+  int indexCount = mesh->depthIndices.size();
+  if( indexCount == 0 )
+    return;
+  optimizeVertexCache( mesh->depthIndices.data(), indexCount, positionCount );
+  std::vector<int> remap;
+  int usedCount = optimizeVertexFetchRemap( mesh->depthIndices.data(), indexCount, positionCount, remap );
+  mesh->depthPositions.resize( (size_t)usedCount * mesh->depthPositionSize );
+  const std::vector< PositionUnit > & units = welder.units();
+  for( int i = 0; i < positionCount; i++ ){
+    if( remap[i] >= 0 )
+      memcpy( &mesh->depthPositions[(size_t)remap[i] * mesh->depthPositionSize], &units[i], mesh->depthPositionSize );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
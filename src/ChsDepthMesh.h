@@ -0,0 +1,17 @@
+#ifndef _CHSDEPTHMESH_H
+#define _CHSDEPTHMESH_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Welds the mesh on position alone into depthPositions and depthIndices, one triangle list
+//	over all submeshes for depth and shadow passes that ignore materials, normals and uv seams.
+//	positions hold positionSize bytes per mesh vertex, positionStride apart, exactly as the main
+//	stream stores them, so the depth and color passes rasterize bitwise equal positions.
+//--------------------------------------------------------------------------------------------------
+void buildDepthMesh( ChsMeshSharedPtr & mesh, const unsigned char * positions, int positionStride,
+                     int positionSize );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSDEPTHMESH_H
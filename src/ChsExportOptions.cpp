@@ -0,0 +1,104 @@
+#include <stdlib.h>
+
+#include "ChsExportOptions.h"
+#include "ChsChunkCompressor.h"
+
+//--------------------------------------------------------------------------------------------------
+void parseFloatList( const std::string & value, std::vector<float> & list ){
+  list.clear();
+  size_t start = 0;
+  while( start < value.size() ){
+    size_t end = value.find( ',', start );
+    if( end == std::string::npos )
+      end = value.size();
+    float item = atof( value.substr( start, end - start ).c_str() );
+    if( item > 0.0f && item < 1.0f )
+      list.push_back( item );
+    start = end + 1;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void parseNameList( const std::string & value, std::vector<std::string> & list ){
+  list.clear();
+  size_t start = 0;
+  while( start < value.size() ){
+    size_t end = value.find( ',', start );
+    if( end == std::string::npos )
+      end = value.size();
+    if( end > start )
+      list.push_back( value.substr( start, end - start ) );
+    start = end + 1;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void setExportOption( const std::string & name, const std::string & value, ChsExportOptions & options ){
+  int intValue = atoi( value.c_str() );
+  if( name == "splitMeshes" )
+    options.splitMeshes = intValue != 0;
+  else if( name == "overdrawThreshold" )
+    options.overdrawThreshold = atof( value.c_str() );
+  else if( name == "meshlets" )
+    options.buildMeshlets = intValue != 0;
+  else if( name == "meshletVertices" && intValue > 0 )
+    options.meshletVertices = intValue;
+  else if( name == "meshletTriangles" && intValue > 0 )
+    options.meshletTriangles = intValue;
+  else if( name == "lods" )
+    parseFloatList( value, options.lodRatios );
+  else if( name == "lodError" )
+    options.lodError = atof( value.c_str() );
+  else if( name == "quantize" )
+    options.quantizeVertices = intValue != 0;
+  else if( name == "normalBits" && ( intValue == 8 || intValue == 16 ) )
+    options.normalBits = intValue;
+  else if( name == "splitStreams" )
+    options.splitStreams = intValue != 0;
+  else if( name == "tangents" )
+    options.buildTangents = intValue != 0;
+  else if( name == "depthMesh" )
+    options.buildDepthMesh = intValue != 0;
+  else if( name == "staticBatching" )
+    options.batchStaticMeshes = intValue != 0;
+  else if( name == "indexCodec" )
+    options.encodeIndices = intValue != 0;
+  else if( name == "vertexCodec" )
+    options.encodeVertices = intValue != 0;
+  else if( name == "compress" )
+    options.compressBinary = intValue != 0;
+  else if( name == "chunkSize" && intValue > 0 && intValue <= CHS_MAX_CHUNK_SIZE / 1024 )
+    options.chunkSize = intValue * 1024;
+  else if( name == "geometryCodec" )
+    options.compressGeometry = intValue != 0;
+  else if( name == "positionBits" && intValue > 0 && intValue <= 16 )
+    options.positionBits = intValue;
+  else if( name == "texcoordBits" && intValue > 0 && intValue <= 16 )
+    options.texcoordBits = intValue;
+  else if( name == "containerVersion" && ( intValue == 1 || intValue == 2 ) )
+    options.containerVersion = intValue;
+  else if( name == "pageAlign" )
+    options.pageAlignChunks = intValue != 0;
+  else if( name == "benchmark" )
+    options.runBenchmarks = intValue != 0;
+  else if( name == "meshes" )
+    parseNameList( value, options.importMeshIds );
+}
+
+//--------------------------------------------------------------------------------------------------
+void parseExportOptions( const std::string & optionsString, ChsExportOptions & options ){
+  options = ChsExportOptions();
+  size_t start = 0;
+  while( start < optionsString.size() ){
+    size_t end = optionsString.find( ';', start );
+    if( end == std::string::npos )
+      end = optionsString.size();
+    std::string option = optionsString.substr( start, end - start );
+    size_t equal = option.find( '=' );
+    if( equal != std::string::npos )
+      setExportOption( option.substr( 0, equal ), option.substr( equal + 1 ), options );
+    start = end + 1;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,52 @@
+#ifndef _CHSEXPORTOPTIONS_H
+#define _CHSEXPORTOPTIONS_H
+//--------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//	Switches read from the translator options string, "name=value;name=value"
+//--------------------------------------------------------------------------------------------------
+struct ChsExportOptions{
+  bool splitMeshes;
+  float overdrawThreshold;  //0 disables the overdraw pass
+  bool buildMeshlets;
+  int meshletVertices;
+  int meshletTriangles;
+  std::vector<float> lodRatios; //"lods=0.5,0.25,0.1", triangle ratio of every extra level
+  float lodError;               //simplification error bound, relative to the mesh extent
+  bool quantizeVertices;
+  int normalBits;               //8 or 16 bits per octahedral normal component when quantized
+  bool splitStreams;            //positions in a stream of their own
+  bool buildTangents;
+  bool buildDepthMesh;          //extra position welded index buffer for depth passes
+  bool batchStaticMeshes;       //merge unanimated meshes per material, transforms baked in
+  bool encodeIndices;           //index codec for the index and lod blocks
+  bool encodeVertices;          //vertex codec filter for the vertex block
+  bool compressBinary;          //lz4 chunks over the binary part, per chunk in version 2
+  int chunkSize;                //bytes, "chunkSize=256" in KB, up to 64 MB
+  bool compressGeometry;        //high ratio geometry codec for the vertex and index blocks
+  int positionBits;             //geometry codec quantization
+  int texcoordBits;
+  int containerVersion;         //1 the old size prefixed blocks, "containerVersion=2" chunked and aligned
+  bool pageAlignChunks;         //4 KB chunk alignment instead of 64 bytes, version 2 only
+  bool runBenchmarks;           //import only, stream against mapped load; codec timings are in benchmark/
+  std::vector<std::string> importMeshIds;  //import only, "meshes=a,b" looked up in the mesh directory
+  
+  ChsExportOptions( void ) : splitMeshes( false ), overdrawThreshold( 0.0f ),
+                             buildMeshlets( false ), meshletVertices( 64 ), meshletTriangles( 124 ),
+                             lodError( 0.05f ), quantizeVertices( false ), normalBits( 16 ),
+                             splitStreams( false ), buildTangents( false ),
+                             buildDepthMesh( false ), batchStaticMeshes( false ),
+                             encodeIndices( false ), encodeVertices( false ),
+                             compressBinary( false ), chunkSize( 256 * 1024 ),
+                             compressGeometry( false ), positionBits( 14 ), texcoordBits( 12 ),
+                             containerVersion( 1 ), pageAlignChunks( false ), runBenchmarks( false ){}
+};
+
+//--------------------------------------------------------------------------------------------------
+void parseExportOptions( const std::string & optionsString, ChsExportOptions & options );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSEXPORTOPTIONS_H
@@ -0,0 +1,127 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "ChsFileWriter.h"
+
+//--------------------------------------------------------------------------------------------------
+enum{
+  PAGE_SIZE_ALIGNMENT = 4096,
+};
+
+//--------------------------------------------------------------------------------------------------
+ChsFileWriter::ChsFileWriter( size_t bufferSize ) : file( -1 ), buffer( NULL ), bufferSize( bufferSize ),
+                                                    usedSize( 0 ), writtenCount( 0 ), writeCallCount( 0 ),
+                                                    isFailed( false ){
+  void * memory = NULL;
+  if( posix_memalign( &memory, PAGE_SIZE_ALIGNMENT, bufferSize ) == 0 )
+    buffer = static_cast<unsigned char *>( memory );
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsFileWriter::~ChsFileWriter( void ){
+  close();
+  free( buffer );
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsFileWriter::open( const char * fileName ){
+  close();
+  usedSize = 0;
+  writtenCount = 0;
+  writeCallCount = 0;
+  isFailed = buffer == NULL;
+  file = ::open( fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  return file >= 0 && !isFailed;
+}
+
+//--------------------------------------------------------------------------------------------------
+void ChsFileWriter::write( const void * data, size_t size ){
+  if( isFailed || file < 0 || size == 0 )
+    return;
+  if( size <= bufferSize - usedSize ){
+    memcpy( buffer + usedSize, data, size );
+    usedSize += size;
+  }
+  else if( size < bufferSize / 4 ){
+    flush( NULL, 0 );
+    memcpy( buffer, data, size );
+    usedSize = size;
+  }
+  else{
+    flush( data, size );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	writes the buffered bytes then the payload, short writes and signals just go on
+//--------------------------------------------------------------------------------------------------
+void ChsFileWriter::flush( const void * payload, size_t payloadSize ){
+  struct iovec parts[2];
+  parts[0].iov_base = buffer;
+  parts[0].iov_len = usedSize;
+  parts[1].iov_base = const_cast<void *>( payload );
+  parts[1].iov_len = payloadSize;
+  struct iovec * part = parts;
+  int partCount = 2;
+  while( partCount > 0 && !isFailed ){
+    if( part->iov_len == 0 ){
+      part++;
+      partCount--;
+      continue;
+    }
+    ssize_t count = writev( file, part, partCount );
+    writeCallCount++;
+    if( count < 0 ){
+      isFailed = errno != EINTR;
+      continue;
+    }
+    writtenCount += count;
+    while( partCount > 0 && (size_t)count >= part->iov_len ){
+      count -= part->iov_len;
+      part++;
+      partCount--;
+    }
+    if( partCount > 0 ){
+      part->iov_base = static_cast<unsigned char *>( part->iov_base ) + count;
+      part->iov_len -= count;
+    }
+  }
+  usedSize = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsFileWriter::patch( unsigned long long offset, const void * data, size_t size ){
+  if( isFailed || file < 0 || offset + size > writtenCount + usedSize )
+    return false;
+  flush( NULL, 0 );
+  const unsigned char * bytes = static_cast<const unsigned char *>( data );
+  while( size > 0 && !isFailed ){
+    ssize_t count = pwrite( file, bytes, size, offset );
+    writeCallCount++;
+    if( count < 0 ){
+      isFailed = errno != EINTR;
+      continue;
+    }
+    bytes += count;
+    size -= count;
+    offset += count;
+  }
+  return !isFailed;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsFileWriter::close( void ){
+  if( file < 0 )
+    return !isFailed;
+  flush( NULL, 0 );
+  if( ::close( file ) != 0 )
+    isFailed = true;
+  file = -1;
+  return !isFailed;
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,76 @@
+#ifndef _CHSFILEWRITER_H
+#define _CHSFILEWRITER_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//	Where the exporter writes its bytes, patch rewrites bytes already written once the offsets
+//	a header holds are known
+//--------------------------------------------------------------------------------------------------
+class ChsOutputSink{
+public:
+  virtual ~ChsOutputSink( void ){}
+  virtual void write( const void * data, size_t size ) = 0;
+  virtual bool patch( unsigned long long offset, const void * data, size_t size ) = 0;
+};
+
+//--------------------------------------------------------------------------------------------------
+class ChsMemoryWriter : public ChsOutputSink{
+public:
+  void write( const void * data, size_t size ){
+    const unsigned char * bytes = static_cast<const unsigned char *>( data );
+    buffer.insert( buffer.end(), bytes, bytes + size );
+  }
+  bool patch( unsigned long long offset, const void * data, size_t size ){
+    if( offset > buffer.size() || size > buffer.size() - offset )
+      return false;
+    memcpy( &buffer[offset], data, size );
+    return true;
+  }
+  std::vector<unsigned char> buffer;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Binary file output through one page aligned buffer. Small writes are copied into it, a large
+//	one goes out together with what is buffered in a single writev, without a copy, so headers
+//	ride along with their payloads and the syscall count follows the payload count.
+//--------------------------------------------------------------------------------------------------
+enum{
+  CHS_FILE_BUFFER_SIZE = 8 * 1024 * 1024,
+};
+
+class ChsFileWriter : public ChsOutputSink{
+public:
+  explicit ChsFileWriter( size_t bufferSize = CHS_FILE_BUFFER_SIZE );
+  ~ChsFileWriter( void );
+  bool open( const char * fileName );
+  void write( const void * data, size_t size );
+  bool patch( unsigned long long offset, const void * data, size_t size );
+  //flushes and closes, false when any write failed
+  bool close( void );
+  unsigned long long bytesWritten( void )const{
+    return writtenCount;
+  }
+  int syscallCount( void )const{
+    return writeCallCount;
+  }
+
+private:
+  ChsFileWriter( const ChsFileWriter & );
+  ChsFileWriter & operator=( const ChsFileWriter & );
+  void flush( const void * payload, size_t payloadSize );
+
+  int file;
+  unsigned char * buffer;
+  size_t bufferSize;
+  size_t usedSize;
+  unsigned long long writtenCount;
+  int writeCallCount;
+  bool isFailed;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSFILEWRITER_H
@@ -0,0 +1,906 @@
+#include <math.h>
+#include <algorithm>
+#include <string.h>
+
+#include "ChsGeometryCodec.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Stream: header byte, varint vertex count, list count and triangle count of every list, the
+//	attributes ( kind, components, bits, offset bytes, then float minimum and scale of every
+//	component for linear ones ), then the range coded data. Per triangle reached over a gate edge
+//	one class symbol: none ( border ), new vertex and its residuals, the border neighbour of
+//	either gate vertex, recent vertex and its slot, far vertex and its distance back from the
+//	newest one. A list starts, and starts over when the
+//	traversal runs dry, with a triangle of three vertex symbols.
+//--------------------------------------------------------------------------------------------------
+enum{
+  GEOMETRY_HEADER = 0xc0,
+  VERTEX_CACHE_SIZE = 16,
+  CLASS_NONE = 0,
+  CLASS_NEW,
+  CLASS_LEFT,
+  CLASS_RIGHT,
+  CLASS_CACHE,
+  CLASS_FAR,
+  CLASS_BITS = 3,
+  CLASS_CONTEXTS = CLASS_FAR + 2,   //previous gate class, or a start triangle
+  PROBABILITY_BITS = 11,
+  PROBABILITY_SHIFT = 5,
+  LENGTH_BITS = 6,
+  MAX_COMPONENTS = CHS_GEOMETRY_MAX_ATTRIBUTES * 4,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	LZMA style binary range coder with adaptive bit probabilities
+//--------------------------------------------------------------------------------------------------
+class RangeEncoder{
+public:
+  RangeEncoder( std::vector<unsigned char> & output ) : output( output ), low( 0 ), range( 0xffffffff ),
+                                                         cache( 0 ), cacheSize( 1 ){}
+  void encodeBit( unsigned short & probability, unsigned int bit ){
+    unsigned int bound = ( range >> PROBABILITY_BITS ) * probability;
+    if( bit == 0 ){
+      range = bound;
+      probability += ( ( 1 << PROBABILITY_BITS ) - probability ) >> PROBABILITY_SHIFT;
+    }
+    else{
+      low += bound;
+      range -= bound;
+      probability -= probability >> PROBABILITY_SHIFT;
+    }
+    normalize();
+  }
+  void encodeDirect( unsigned int value, int count ){
+    while( count-- ){
+      range >>= 1;
+      if( ( value >> count ) & 1 )
+        low += range;
+      normalize();
+    }
+  }
+  void flush( void ){
+    for( int i = 0; i < 5; i++ )
+      shiftLow();
+  }
+
+private:
+  void normalize( void ){
+    while( range < ( 1u << 24 ) ){
+      range <<= 8;
+      shiftLow();
+    }
+  }
+  void shiftLow( void ){
+    if( (unsigned int)low < 0xff000000u || ( low >> 32 ) != 0 ){
+      unsigned char carry = (unsigned char)( low >> 32 );
+      unsigned char byte = cache;
+      do{
+        output.push_back( (unsigned char)( byte + carry ) );
+        byte = 0xff;
+      }while( --cacheSize != 0 );
+      cache = (unsigned char)( low >> 24 );
+    }
+    cacheSize++;
+    low = ( low & 0x00ffffff ) << 8;
+  }
+  std::vector<unsigned char> & output;
+  unsigned long long low;
+  unsigned int range;
+  unsigned char cache;
+  unsigned long long cacheSize;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	reads past the end as zeros and remembers it, a valid stream never does
+//--------------------------------------------------------------------------------------------------
+class RangeDecoder{
+public:
+  RangeDecoder( const unsigned char * data, const unsigned char * end ) : data( data ), end( end ), code( 0 ),
+                                                                          range( 0xffffffff ), isOverrun( false ){
+    for( int i = 0; i < 5; i++ )
+      code = ( code << 8 ) | readByte();
+  }
+  unsigned int decodeBit( unsigned short & probability ){
+    unsigned int bound = ( range >> PROBABILITY_BITS ) * probability;
+    unsigned int bit;
+    if( code < bound ){
+      range = bound;
+      probability += ( ( 1 << PROBABILITY_BITS ) - probability ) >> PROBABILITY_SHIFT;
+      bit = 0;
+    }
+    else{
+      code -= bound;
+      range -= bound;
+      probability -= probability >> PROBABILITY_SHIFT;
+      bit = 1;
+    }
+    normalize();
+    return bit;
+  }
+  unsigned int decodeDirect( int count ){
+    unsigned int value = 0;
+    while( count-- ){
+      range >>= 1;
+      unsigned int bit = code >= range;
+      if( bit )
+        code -= range;
+      value = ( value << 1 ) | bit;
+      normalize();
+    }
+    return value;
+  }
+  bool overrun( void )const{
+    return isOverrun;
+  }
+
+private:
+  void normalize( void ){
+    if( range < ( 1u << 24 ) ){
+      range <<= 8;
+      code = ( code << 8 ) | readByte();
+    }
+  }
+  unsigned int readByte( void ){
+    if( data < end )
+      return *data++;
+    isOverrun = true;
+    return 0;
+  }
+  const unsigned char * data;
+  const unsigned char * end;
+  unsigned int code;
+  unsigned int range;
+  bool isOverrun;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Exp-Golomb like numbers: the bit length through an adaptive tree, the bits under the top one
+//	as they are
+//--------------------------------------------------------------------------------------------------
+struct NumberModel{
+  unsigned short lengths[1 << LENGTH_BITS];
+};
+
+//--------------------------------------------------------------------------------------------------
+struct GeometryModels{
+  unsigned short classes[CLASS_CONTEXTS][1 << CLASS_BITS];
+  unsigned short cacheSlots[VERTEX_CACHE_SIZE];
+  NumberModel distance;
+  NumberModel residuals[MAX_COMPONENTS][2];   //predicted by the delta or the parallelogram
+
+  GeometryModels( void ){
+    unsigned short * probabilities = &classes[0][0];
+    size_t count = sizeof( GeometryModels ) / sizeof( unsigned short );
+    for( size_t i = 0; i < count; i++ )
+      probabilities[i] = 1 << ( PROBABILITY_BITS - 1 );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+static void encodeTree( RangeEncoder & coder, unsigned short * probabilities, int bits, unsigned int value ){
+  unsigned int node = 1;
+  for( int i = bits - 1; i >= 0; i-- ){
+    unsigned int bit = ( value >> i ) & 1;
+    coder.encodeBit( probabilities[node], bit );
+    node = ( node << 1 ) | bit;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static unsigned int decodeTree( RangeDecoder & coder, unsigned short * probabilities, int bits ){
+  unsigned int node = 1;
+  for( int i = 0; i < bits; i++ )
+    node = ( node << 1 ) | coder.decodeBit( probabilities[node] );
+  return node - ( 1 << bits );
+}
+
+//--------------------------------------------------------------------------------------------------
+static void encodeNumber( RangeEncoder & coder, NumberModel & model, unsigned int value ){
+  int length = 0;
+  while( length < 32 && ( value >> length ) != 0 )
+    length++;
+  encodeTree( coder, model.lengths, LENGTH_BITS, length );
+  if( length > 1 )
+    coder.encodeDirect( value, length - 1 );
+}
+
+//--------------------------------------------------------------------------------------------------
+static bool decodeNumber( RangeDecoder & coder, NumberModel & model, unsigned int & value ){
+  unsigned int length = decodeTree( coder, model.lengths, LENGTH_BITS );
+  if( length > 32 )
+    return false;
+  value = length == 0 ? 0 : 1;
+  if( length > 1 )
+    value = ( 1u << ( length - 1 ) ) | coder.decodeDirect( length - 1 );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int zigzag( int value ){
+  return ( (unsigned int)value << 1 ) ^ (unsigned int)( value >> 31 );
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline int unzigzag( unsigned int value ){
+  return (int)( value >> 1 ) ^ -(int)( value & 1 );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	directed edges as a list per start vertex, a handful each on any sane mesh, and close in
+//	memory since vertices come in traversal order
+//--------------------------------------------------------------------------------------------------
+class EdgeLists{
+public:
+  void reset( unsigned int vertexCount, int edgeCount ){
+    heads.assign( vertexCount, -1 );
+    edges.clear();
+    edges.reserve( edgeCount );
+  }
+  void insert( unsigned int a, unsigned int b, int value ){
+    Edge edge = { b, value, heads[a] };
+    heads[a] = edges.size();
+    edges.push_back( edge );
+  }
+  //first edge from a to b, -1 when there is none
+  int find( unsigned int a, unsigned int b )const{
+    return findFrom( heads[a], b );
+  }
+  int findNext( int edge )const{
+    return findFrom( edges[edge].next, edges[edge].target );
+  }
+  bool contains( unsigned int a, unsigned int b )const{
+    return find( a, b ) >= 0;
+  }
+  int value( int edge )const{
+    return edges[edge].value;
+  }
+
+private:
+  struct Edge{
+    unsigned int target;
+    int value;
+    int next;
+  };
+  int findFrom( int edge, unsigned int b )const{
+    while( edge >= 0 && edges[edge].target != b )
+      edge = edges[edge].next;
+    return edge;
+  }
+  std::vector<int> heads;
+  std::vector<Edge> edges;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	edge of a visited triangle still to cross, opposite is the third vertex of that triangle
+//--------------------------------------------------------------------------------------------------
+struct Gate{
+  unsigned int a;
+  unsigned int b;
+  unsigned int opposite;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Triangles known to the decoder: their directed edges, and the border of the region as next
+//	and previous vertex along it. A third vertex closing a triangle against the border is the one
+//	before a ( left ) or after b ( right ), edgebreaker's L and R.
+//--------------------------------------------------------------------------------------------------
+static const unsigned int NO_VERTEX = 0xffffffff;
+
+struct DecodedRegion{
+  EdgeLists edges;
+  std::vector<unsigned int> borderNext;
+  std::vector<unsigned int> borderPrevious;
+
+  void reset( int triangleCount, unsigned int vertexCount ){
+    edges.reset( vertexCount, triangleCount * 3 );
+    borderNext.assign( vertexCount, NO_VERTEX );
+    borderPrevious.assign( vertexCount, NO_VERTEX );
+  }
+  bool isCrossed( const Gate & gate )const{
+    return edges.contains( gate.b, gate.a );
+  }
+  unsigned int left( const Gate & gate )const{
+    return borderPrevious[gate.a];
+  }
+  unsigned int right( const Gate & gate )const{
+    return borderNext[gate.b];
+  }
+  void addTriangle( const unsigned int * triangle ){
+    for( int k = 0; k < 3; k++ ){
+      unsigned int u = triangle[k], v = triangle[( k + 1 ) % 3];
+      if( edges.contains( v, u ) ){
+        if( borderNext[v] == u )
+          borderNext[v] = NO_VERTEX;
+        if( borderPrevious[u] == v )
+          borderPrevious[u] = NO_VERTEX;
+      }
+      else{
+        borderNext[u] = v;
+        borderPrevious[v] = u;
+      }
+    }
+    for( int k = 0; k < 3; k++ )
+      edges.insert( triangle[k], triangle[( k + 1 ) % 3], 0 );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	triangle[0] to triangle[1] is the edge it was reached by unless it starts the traversal
+//--------------------------------------------------------------------------------------------------
+static void pushGates( std::vector<Gate> & stack, const unsigned int * triangle, bool isStart ){
+  if( isStart ){
+    Gate gate = { triangle[0], triangle[1], triangle[2] };
+    stack.push_back( gate );
+  }
+  Gate left = { triangle[2], triangle[0], triangle[1] };
+  stack.push_back( left );
+  Gate right = { triangle[1], triangle[2], triangle[0] };
+  stack.push_back( right );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	most recently used vertices, slot 0 is the newest
+//--------------------------------------------------------------------------------------------------
+struct VertexCache{
+  unsigned int slots[VERTEX_CACHE_SIZE];
+
+  VertexCache( void ){
+    memset( slots, 0xff, sizeof( slots ) );
+  }
+  int find( unsigned int v )const{
+    for( int i = 0; i < VERTEX_CACHE_SIZE; i++ ){
+      if( slots[i] == v )
+        return i;
+    }
+    return -1;
+  }
+  void touch( unsigned int v ){
+    int i = find( v );
+    if( i < 0 )
+      i = VERTEX_CACHE_SIZE - 1;
+    memmove( slots + 1, slots, i * sizeof( unsigned int ) );
+    slots[0] = v;
+  }
+  void touchTriangle( const unsigned int * triangle ){
+    touch( triangle[0] );
+    touch( triangle[1] );
+    touch( triangle[2] );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Walks one list the way the decoder will, calling the visitor for every start triangle,
+//	every triangle reached over a gate and every gate with nothing behind it. Among triangles
+//	behind a gate the lowest unvisited one wins, so a list in traversal order walks in order.
+//--------------------------------------------------------------------------------------------------
+template <typename Visitor> void traverseList( const unsigned int * indices, int triangleCount, Visitor & visitor ){
+  int cornerCount = triangleCount * 3;
+  unsigned int vertexCount = 0;
+  for( int corner = 0; corner < cornerCount; corner++ )
+    vertexCount = std::max( vertexCount, indices[corner] + 1 );
+  EdgeLists adjacency;
+  adjacency.reset( vertexCount, cornerCount );
+  for( int corner = 0; corner < cornerCount; corner++ ){
+    int second = corner % 3 == 2 ? corner - 2 : corner + 1;
+    adjacency.insert( indices[corner], indices[second], corner );
+  }
+  DecodedRegion region;
+  region.reset( triangleCount, vertexCount );
+  std::vector<bool> isVisited( triangleCount, false );
+  std::vector<Gate> stack;
+  int start = 0;
+  int doneCount = 0;
+  while( doneCount < triangleCount ){
+    unsigned int triangle[3];
+    if( stack.empty() ){
+      while( isVisited[start] )
+        start++;
+      memcpy( triangle, indices + start * 3, sizeof( triangle ) );
+      isVisited[start] = true;
+      visitor.visitStart( triangle );
+      pushGates( stack, triangle, true );
+    }
+    else{
+      Gate gate = stack.back();
+      stack.pop_back();
+      if( region.isCrossed( gate ) )
+        continue;
+      int found = -1;
+      for( int edge = adjacency.find( gate.b, gate.a ); edge >= 0; edge = adjacency.findNext( edge ) ){
+        int corner = adjacency.value( edge );
+        if( !isVisited[corner / 3] && ( found < 0 || corner < found ) )
+          found = corner;
+      }
+      if( found < 0 ){
+        visitor.visitBorder();
+        continue;
+      }
+      int first = found - found % 3;
+      triangle[0] = gate.b;
+      triangle[1] = gate.a;
+      triangle[2] = indices[first + ( found - first + 2 ) % 3];
+      isVisited[found / 3] = true;
+      visitor.visitGate( gate, triangle, region );
+      pushGates( stack, triangle, false );
+    }
+    region.addTriangle( triangle );
+    doneCount++;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+struct TriangleCollector{
+  std::vector<unsigned int> & ordered;
+
+  TriangleCollector( std::vector<unsigned int> & ordered ) : ordered( ordered ){}
+  void visitStart( const unsigned int * triangle ){
+    ordered.insert( ordered.end(), triangle, triangle + 3 );
+  }
+  void visitGate( const Gate &, const unsigned int * triangle, const DecodedRegion & ){
+    ordered.insert( ordered.end(), triangle, triangle + 3 );
+  }
+  void visitBorder( void ){}
+};
+
+//--------------------------------------------------------------------------------------------------
+void orderGeometryTriangles( unsigned int * indices, const int * indexCounts, int listCount ){
+  std::vector<unsigned int> ordered;
+  for( int list = 0; list < listCount; list++ ){
+    ordered.clear();
+    TriangleCollector collector( ordered );
+    traverseList( indices, indexCounts[list] / 3, collector );
+    std::copy( ordered.begin(), ordered.end(), indices );
+    indices += indexCounts[list];
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	quantized components of every vertex, shared by both sides
+//--------------------------------------------------------------------------------------------------
+struct QuantizedVertices{
+  std::vector<int> values;
+  int componentCount;
+  int maxValues[MAX_COMPONENTS];
+
+  const int * vertex( unsigned int v )const{
+    return values.data() + v * componentCount;
+  }
+  int * vertex( unsigned int v ){
+    return values.data() + v * componentCount;
+  }
+  //parallelogram over the gate, or the previous new vertex for start triangles
+  void predict( int * prediction, const Gate * gate, unsigned int nextVertex )const{
+    if( gate == NULL ){
+      for( int i = 0; i < componentCount; i++ )
+        prediction[i] = nextVertex > 0 ? vertex( nextVertex - 1 )[i] : 0;
+      return;
+    }
+    const int * a = vertex( gate->a );
+    const int * b = vertex( gate->b );
+    const int * opposite = vertex( gate->opposite );
+    for( int i = 0; i < componentCount; i++ ){
+      int value = a[i] + b[i] - opposite[i];
+      prediction[i] = value < 0 ? 0 : ( value > maxValues[i] ? maxValues[i] : value );
+    }
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+static int quantizedComponentCount( const ChsGeometryAttribute & attribute ){
+  if( attribute.kind == CHS_GEOMETRY_NORMAL )
+    return 2;
+  if( attribute.kind == CHS_GEOMETRY_TANGENT )
+    return 3;
+  return attribute.components;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline int quantizeUnit( float value, int maxValue ){
+  int q = (int)floorf( ( value * 0.5f + 0.5f ) * maxValue + 0.5f );
+  return q < 0 ? 0 : ( q > maxValue ? maxValue : q );
+}
+
+//--------------------------------------------------------------------------------------------------
+static void encodeOctahedral( const float * n, int maxValue, int * q ){
+  float length = fabsf( n[0] ) + fabsf( n[1] ) + fabsf( n[2] );
+  float x = length > 0.0f ? n[0] / length : 1.0f;
+  float y = length > 0.0f ? n[1] / length : 0.0f;
+  if( length > 0.0f && n[2] < 0.0f ){
+    float folded = ( 1.0f - fabsf( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+    y = ( 1.0f - fabsf( x ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+    x = folded;
+  }
+  q[0] = quantizeUnit( x, maxValue );
+  q[1] = quantizeUnit( y, maxValue );
+}
+
+//--------------------------------------------------------------------------------------------------
+static void decodeOctahedral( const int * q, int maxValue, float * n ){
+  float x = q[0] * 2.0f / maxValue - 1.0f;
+  float y = q[1] * 2.0f / maxValue - 1.0f;
+  float z = 1.0f - fabsf( x ) - fabsf( y );
+  if( z < 0.0f ){
+    float folded = ( 1.0f - fabsf( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+    y = ( 1.0f - fabsf( x ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+    x = folded;
+  }
+  float length = sqrtf( x * x + y * y + z * z );
+  n[0] = x / length;
+  n[1] = y / length;
+  n[2] = z / length;
+}
+
+//--------------------------------------------------------------------------------------------------
+static unsigned char * writeVarint( unsigned char * data, unsigned int value ){
+  while( value >= 0x80 ){
+    *data++ = (unsigned char)( value | 0x80 );
+    value >>= 7;
+  }
+  *data++ = (unsigned char)value;
+  return data;
+}
+
+//--------------------------------------------------------------------------------------------------
+static void appendVarint( std::vector<unsigned char> & buffer, unsigned int value ){
+  unsigned char bytes[5];
+  buffer.insert( buffer.end(), bytes, writeVarint( bytes, value ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+static void appendFloat( std::vector<unsigned char> & buffer, float value ){
+  const unsigned char * bytes = reinterpret_cast<const unsigned char *>( &value );
+  buffer.insert( buffer.end(), bytes, bytes + sizeof( float ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	encoder side visitor, fails as soon as the lists turn out not to be in traversal order
+//--------------------------------------------------------------------------------------------------
+struct GeometryEncoder{
+  RangeEncoder coder;
+  GeometryModels models;
+  VertexCache cache;
+  const QuantizedVertices & quantized;
+  unsigned int vertexCount;
+  unsigned int nextVertex;
+  const unsigned int * expected;   //next triangle of the list
+  int previousClass;
+  bool isFailed;
+
+  GeometryEncoder( std::vector<unsigned char> & buffer, const QuantizedVertices & quantized, unsigned int vertexCount )
+    : coder( buffer ), quantized( quantized ), vertexCount( vertexCount ), nextVertex( 0 ), expected( NULL ),
+      previousClass( CLASS_NONE ), isFailed( false ){}
+
+  //returns the class the vertex went out as
+  int encodeVertex( unsigned int v, const Gate * gate, const DecodedRegion * region ){
+    int context = gate == NULL ? CLASS_CONTEXTS - 1 : previousClass;
+    int slot = cache.find( v );
+    if( v == nextVertex ){
+      encodeTree( coder, models.classes[context], CLASS_BITS, CLASS_NEW );
+      int prediction[MAX_COMPONENTS];
+      quantized.predict( prediction, gate, nextVertex );
+      const int * values = quantized.vertex( v );
+      for( int i = 0; i < quantized.componentCount; i++ )
+        encodeNumber( coder, models.residuals[i][gate != NULL], zigzag( values[i] - prediction[i] ) );
+      nextVertex++;
+      return CLASS_NEW;
+    }
+    if( gate != NULL && region->left( *gate ) == v ){
+      encodeTree( coder, models.classes[context], CLASS_BITS, CLASS_LEFT );
+      return CLASS_LEFT;
+    }
+    if( gate != NULL && region->right( *gate ) == v ){
+      encodeTree( coder, models.classes[context], CLASS_BITS, CLASS_RIGHT );
+      return CLASS_RIGHT;
+    }
+    if( slot >= 0 ){
+      encodeTree( coder, models.classes[context], CLASS_BITS, CLASS_CACHE );
+      encodeTree( coder, models.cacheSlots, 4, slot );
+      return CLASS_CACHE;
+    }
+    if( v < nextVertex ){
+      encodeTree( coder, models.classes[context], CLASS_BITS, CLASS_FAR );
+      encodeNumber( coder, models.distance, nextVertex - 1 - v );
+      return CLASS_FAR;
+    }
+    isFailed = true;
+    return CLASS_NONE;
+  }
+  void checkOrder( const unsigned int * triangle ){
+    if( memcmp( triangle, expected, 3 * sizeof( unsigned int ) ) != 0 )
+      isFailed = true;
+    expected += 3;
+  }
+  void visitStart( const unsigned int * triangle ){
+    checkOrder( triangle );
+    for( int k = 0; k < 3; k++ )
+      encodeVertex( triangle[k], NULL, NULL );
+    cache.touchTriangle( triangle );
+  }
+  void visitGate( const Gate & gate, const unsigned int * triangle, const DecodedRegion & region ){
+    checkOrder( triangle );
+    previousClass = encodeVertex( triangle[2], &gate, &region );
+    cache.touchTriangle( triangle );
+  }
+  void visitBorder( void ){
+    encodeTree( coder, models.classes[previousClass], CLASS_BITS, CLASS_NONE );
+    previousClass = CLASS_NONE;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+bool encodeGeometry( std::vector<unsigned char> & buffer, const float * vertices, int vertexCount, int vertexStride,
+                     const ChsGeometryAttribute * attributes, int attributeCount,
+                     const unsigned int * indices, const int * indexCounts, int listCount ){
+  buffer.clear();
+  if( attributeCount > CHS_GEOMETRY_MAX_ATTRIBUTES )
+    return false;
+  buffer.push_back( GEOMETRY_HEADER | CHS_GEOMETRY_CODEC_VERSION );
+  appendVarint( buffer, vertexCount );
+  appendVarint( buffer, listCount );
+  for( int list = 0; list < listCount; list++ )
+    appendVarint( buffer, indexCounts[list] / 3 );
+  buffer.push_back( (unsigned char)attributeCount );
+  //quantize every attribute, linear ones inside their bounds
+  QuantizedVertices quantized;
+  quantized.componentCount = 0;
+  for( int i = 0; i < attributeCount; i++ )
+    quantized.componentCount += quantizedComponentCount( attributes[i] );
+  quantized.values.resize( vertexCount * quantized.componentCount );
+  int component = 0;
+  for( int i = 0; i < attributeCount; i++ ){
+    const ChsGeometryAttribute & attribute = attributes[i];
+    int maxValue = ( 1 << attribute.bits ) - 1;
+    buffer.push_back( (unsigned char)attribute.kind );
+    buffer.push_back( (unsigned char)attribute.components );
+    buffer.push_back( (unsigned char)attribute.bits );
+    buffer.push_back( (unsigned char)attribute.offset );
+    if( attribute.kind == CHS_GEOMETRY_LINEAR ){
+      for( int k = 0; k < attribute.components; k++, component++ ){
+        float minimum = 0.0f, maximum = 0.0f;
+        for( int v = 0; v < vertexCount; v++ ){
+          float value = vertices[v * vertexStride + attribute.offset + k];
+          minimum = v == 0 || value < minimum ? value : minimum;
+          maximum = v == 0 || value > maximum ? value : maximum;
+        }
+        float scale = ( maximum - minimum ) / maxValue;
+        appendFloat( buffer, minimum );
+        appendFloat( buffer, scale );
+        quantized.maxValues[component] = maxValue;
+        for( int v = 0; v < vertexCount; v++ ){
+          float value = vertices[v * vertexStride + attribute.offset + k];
+          int q = scale > 0.0f ? (int)floorf( ( value - minimum ) / scale + 0.5f ) : 0;
+          quantized.vertex( v )[component] = q > maxValue ? maxValue : q;
+        }
+      }
+    }
+    else{
+      for( int v = 0; v < vertexCount; v++ ){
+        const float * source = vertices + v * vertexStride + attribute.offset;
+        int * q = quantized.vertex( v ) + component;
+        encodeOctahedral( source, maxValue, q );
+        if( attribute.kind == CHS_GEOMETRY_TANGENT )
+          q[2] = source[3] >= 0.0f ? 1 : 0;
+      }
+      quantized.maxValues[component] = quantized.maxValues[component + 1] = maxValue;
+      if( attribute.kind == CHS_GEOMETRY_TANGENT )
+        quantized.maxValues[component + 2] = 1;
+      component += quantizedComponentCount( attribute );
+    }
+  }
+  int indexTotal = 0;
+  for( int list = 0; list < listCount; list++ )
+    indexTotal += indexCounts[list];
+  for( int i = 0; i < indexTotal; i++ ){
+    if( indices[i] >= (unsigned int)vertexCount )
+      return false;
+  }
+  GeometryEncoder encoder( buffer, quantized, vertexCount );
+  encoder.expected = indices;
+  for( int list = 0; list < listCount && !encoder.isFailed; list++ ){
+    traverseList( indices, indexCounts[list] / 3, encoder );
+    indices += indexCounts[list];
+  }
+  encoder.coder.flush();
+  //unreferenced vertices would need a symbol of their own, fetch optimized meshes have none
+  return !encoder.isFailed && encoder.nextVertex == (unsigned int)vertexCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	decoder side, every count is checked against the caller's buffers before it is used
+//--------------------------------------------------------------------------------------------------
+static bool readVarint( const unsigned char * & data, const unsigned char * end, unsigned int & value ){
+  value = 0;
+  for( int shift = 0; shift < 35; shift += 7 ){
+    if( data == end )
+      return false;
+    unsigned char byte = *data++;
+    value |= (unsigned int)( byte & 0x7f ) << shift;
+    if( byte < 0x80 )
+      return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+struct GeometryDecoder{
+  RangeDecoder coder;
+  GeometryModels models;
+  VertexCache cache;
+  QuantizedVertices & quantized;
+  unsigned int vertexCount;
+  unsigned int nextVertex;
+  int previousClass;
+
+  GeometryDecoder( const unsigned char * data, const unsigned char * end, QuantizedVertices & quantized,
+                   unsigned int vertexCount )
+    : coder( data, end ), quantized( quantized ), vertexCount( vertexCount ), nextVertex( 0 ),
+      previousClass( CLASS_NONE ){}
+
+  bool decodeVertex( unsigned int vertexClass, const Gate * gate, const DecodedRegion & region, unsigned int & v ){
+    if( vertexClass == CLASS_NEW ){
+      if( nextVertex >= vertexCount )
+        return false;
+      int prediction[MAX_COMPONENTS];
+      quantized.predict( prediction, gate, nextVertex );
+      int * values = quantized.vertex( nextVertex );
+      for( int i = 0; i < quantized.componentCount; i++ ){
+        unsigned int residual;
+        if( !decodeNumber( coder, models.residuals[i][gate != NULL], residual ) )
+          return false;
+        values[i] = prediction[i] + unzigzag( residual );
+        if( values[i] < 0 || values[i] > quantized.maxValues[i] )
+          return false;
+      }
+      v = nextVertex++;
+      return true;
+    }
+    if( vertexClass == CLASS_LEFT || vertexClass == CLASS_RIGHT ){
+      if( gate == NULL )
+        return false;
+      v = vertexClass == CLASS_LEFT ? region.left( *gate ) : region.right( *gate );
+      return v < nextVertex;
+    }
+    if( vertexClass == CLASS_CACHE ){
+      v = cache.slots[decodeTree( coder, models.cacheSlots, 4 )];
+      return v < nextVertex;
+    }
+    if( vertexClass == CLASS_FAR ){
+      unsigned int distance;
+      if( !decodeNumber( coder, models.distance, distance ) || distance >= nextVertex )
+        return false;
+      v = nextVertex - 1 - distance;
+      return true;
+    }
+    return false;
+  }
+  bool decodeList( unsigned int * indices, int triangleCount ){
+    DecodedRegion region;
+    region.reset( triangleCount, vertexCount );
+    std::vector<Gate> stack;
+    int doneCount = 0;
+    while( doneCount < triangleCount ){
+      unsigned int * triangle = indices + doneCount * 3;
+      if( stack.empty() ){
+        for( int k = 0; k < 3; k++ ){
+          unsigned int vertexClass = decodeTree( coder, models.classes[CLASS_CONTEXTS - 1], CLASS_BITS );
+          if( !decodeVertex( vertexClass, NULL, region, triangle[k] ) )
+            return false;
+        }
+        pushGates( stack, triangle, true );
+      }
+      else{
+        Gate gate = stack.back();
+        stack.pop_back();
+        if( region.isCrossed( gate ) )
+          continue;
+        unsigned int vertexClass = decodeTree( coder, models.classes[previousClass], CLASS_BITS );
+        if( vertexClass > CLASS_FAR )
+          return false;
+        previousClass = vertexClass;
+        if( vertexClass == CLASS_NONE )
+          continue;
+        triangle[0] = gate.b;
+        triangle[1] = gate.a;
+        if( !decodeVertex( vertexClass, &gate, region, triangle[2] ) )
+          return false;
+        pushGates( stack, triangle, false );
+      }
+      cache.touchTriangle( triangle );
+      region.addTriangle( triangle );
+      doneCount++;
+      if( coder.overrun() )
+        return false;
+    }
+    return true;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+int decodeGeometry( float * vertices, int vertexCount, int vertexStride, unsigned int * indices, int indexCount,
+                    const unsigned char * buffer, size_t bufferSize ){
+  const unsigned char * data = buffer;
+  const unsigned char * end = buffer + bufferSize;
+  if( bufferSize < 1 || *data++ != ( GEOMETRY_HEADER | CHS_GEOMETRY_CODEC_VERSION ) )
+    return -1;
+  unsigned int headerVertexCount, listCount;
+  if( !readVarint( data, end, headerVertexCount ) || headerVertexCount != (unsigned int)vertexCount ||
+      !readVarint( data, end, listCount ) || listCount > (unsigned int)indexCount / 3 + 1 )
+    return -1;
+  std::vector<unsigned int> triangleCounts( listCount );
+  unsigned int triangleTotal = 0;
+  for( unsigned int list = 0; list < listCount; list++ ){
+    if( !readVarint( data, end, triangleCounts[list] ) || triangleCounts[list] > (unsigned int)indexCount / 3 )
+      return -1;
+    triangleTotal += triangleCounts[list];
+  }
+  if( triangleTotal * 3 != (unsigned int)indexCount || data == end )
+    return -1;
+  int attributeCount = *data++;
+  if( attributeCount > CHS_GEOMETRY_MAX_ATTRIBUTES )
+    return -1;
+  ChsGeometryAttribute attributes[CHS_GEOMETRY_MAX_ATTRIBUTES];
+  float minimums[MAX_COMPONENTS], scales[MAX_COMPONENTS];
+  QuantizedVertices quantized;
+  quantized.componentCount = 0;
+  for( int i = 0; i < attributeCount; i++ ){
+    ChsGeometryAttribute & attribute = attributes[i];
+    if( end - data < 4 )
+      return -1;
+    attribute.kind = data[0];
+    attribute.components = data[1];
+    attribute.bits = data[2];
+    attribute.offset = data[3];
+    data += 4;
+    bool isLinear = attribute.kind == CHS_GEOMETRY_LINEAR;
+    if( attribute.bits < 1 || attribute.bits > 16 || attribute.offset + attribute.components > vertexStride ||
+        ( isLinear && ( attribute.components < 1 || attribute.components > 4 ) ) ||
+        ( attribute.kind == CHS_GEOMETRY_NORMAL && attribute.components != 3 ) ||
+        ( attribute.kind == CHS_GEOMETRY_TANGENT && attribute.components != 4 ) || attribute.kind > CHS_GEOMETRY_TANGENT )
+      return -1;
+    int maxValue = ( 1 << attribute.bits ) - 1;
+    int count = quantizedComponentCount( attribute );
+    for( int k = 0; k < count; k++ ){
+      int component = quantized.componentCount + k;
+      quantized.maxValues[component] = attribute.kind == CHS_GEOMETRY_TANGENT && k == 2 ? 1 : maxValue;
+      if( isLinear ){
+        if( end - data < 8 )
+          return -1;
+        memcpy( &minimums[component], data, sizeof( float ) );
+        memcpy( &scales[component], data + 4, sizeof( float ) );
+        data += 8;
+      }
+    }
+    quantized.componentCount += count;
+  }
+  quantized.values.resize( vertexCount * quantized.componentCount );
+  GeometryDecoder decoder( data, end, quantized, vertexCount );
+  for( unsigned int list = 0; list < listCount; list++ ){
+    if( !decoder.decodeList( indices, triangleCounts[list] ) )
+      return -1;
+    indices += triangleCounts[list] * 3;
+  }
+  if( decoder.coder.overrun() || decoder.nextVertex != (unsigned int)vertexCount )
+    return -1;
+  //back to floats
+  for( int v = 0; v < vertexCount; v++ ){
+    const int * q = quantized.vertex( v );
+    float * vertex = vertices + v * vertexStride;
+    int component = 0;
+    for( int i = 0; i < attributeCount; i++ ){
+      const ChsGeometryAttribute & attribute = attributes[i];
+      float * destination = vertex + attribute.offset;
+      if( attribute.kind == CHS_GEOMETRY_LINEAR ){
+        for( int k = 0; k < attribute.components; k++, component++ )
+          destination[k] = minimums[component] + q[component] * scales[component];
+        continue;
+      }
+      decodeOctahedral( q + component, quantized.maxValues[component], destination );
+      if( attribute.kind == CHS_GEOMETRY_TANGENT )
+        destination[3] = q[component + 2] ? 1.0f : -1.0f;
+      component += quantizedComponentCount( attribute );
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
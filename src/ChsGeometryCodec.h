@@ -0,0 +1,50 @@
+#ifndef _CHSGEOMETRYCODEC_H
+#define _CHSGEOMETRYCODEC_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//	High ratio mesh codec for distribution builds, slower than the index and vertex codecs.
+//	Connectivity is coded edgebreaker style: triangles are visited depth first across the edges of
+//	visited ones and each new triangle costs one symbol for its third vertex ( new, recent, far ),
+//	edges whose other side is known cost nothing. A new vertex is predicted from the parallelogram
+//	over the edge it was reached by, attributes are quantized first, residuals and symbols go
+//	through an adaptive binary range coder. Lossy by the quantization only.
+//	The encoder takes triangles in traversal order, orderGeometryTriangles puts them in it,
+//	vertices must then be in first use order. Self contained like the other codecs.
+//--------------------------------------------------------------------------------------------------
+enum{
+  CHS_GEOMETRY_CODEC_VERSION = 1,
+  CHS_GEOMETRY_MAX_ATTRIBUTES = 8,
+};
+
+enum ChsGeometryAttributeKind{
+  CHS_GEOMETRY_LINEAR,      //components floats quantized inside their bounds
+  CHS_GEOMETRY_NORMAL,      //3 floats as octahedral
+  CHS_GEOMETRY_TANGENT,     //3 floats as octahedral and a sign in the fourth
+};
+
+struct ChsGeometryAttribute{
+  int kind;
+  int components;   //floats in the vertex, 1 to 4 for linear attributes
+  int bits;         //per quantized component, 1 to 16
+  int offset;       //floats from the start of the vertex
+};
+
+//--------------------------------------------------------------------------------------------------
+//	indexCounts splits the indices into lists coded on their own ( submeshes of one vertex range )
+//--------------------------------------------------------------------------------------------------
+void orderGeometryTriangles( unsigned int * indices, const int * indexCounts, int listCount );
+//returns false when the triangles or vertices are not in codec order
+bool encodeGeometry( std::vector<unsigned char> & buffer, const float * vertices, int vertexCount, int vertexStride,
+                     const ChsGeometryAttribute * attributes, int attributeCount,
+                     const unsigned int * indices, const int * indexCounts, int listCount );
+//vertexStride in floats, indices come back as the lists one after the other,
+//returns 0 on success, -1 on malformed input
+int decodeGeometry( float * vertices, int vertexCount, int vertexStride, unsigned int * indices, int indexCount,
+                    const unsigned char * buffer, size_t bufferSize );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSGEOMETRYCODEC_H
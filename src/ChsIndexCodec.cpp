@@ -0,0 +1,248 @@
+#include <string.h>
+
+#include "ChsIndexCodec.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Stream: header byte, triangleCount code bytes, then the varints of explicit vertices.
+//	Code high nibble 0..14 is a hit in the edge fifo, the low nibble gives the third vertex.
+//	High nibble 15 is a triangle without known edge, the low nibble gives the first vertex and
+//	one byte in the data stream, ahead of their varints, the other two. Vertex nibbles are:
+//	0 next unused index, 1..14 vertex fifo entry, 15 explicit varint.
+//--------------------------------------------------------------------------------------------------
+enum{
+  INDEX_HEADER = 0xe0,
+  EDGE_FIFO_SIZE = 16,
+  VERTEX_FIFO_SIZE = 16,
+  VERTEX_NEXT = 0,
+  VERTEX_EXPLICIT = 15,
+  EDGE_MISS = 15,
+};
+
+struct IndexCodecState{
+  unsigned int edges[EDGE_FIFO_SIZE][2];
+  unsigned int vertices[VERTEX_FIFO_SIZE];
+  unsigned int edgeOffset;
+  unsigned int vertexOffset;
+  unsigned int next;
+  unsigned int last;
+
+  void reset( void ){
+    memset( this, 0xff, sizeof( IndexCodecState ) );
+    edgeOffset = vertexOffset = next = last = 0;
+  }
+  //entry 0 is the most recent one
+  const unsigned int * edge( int index )const{
+    return edges[( edgeOffset - 1 - index ) & ( EDGE_FIFO_SIZE - 1 )];
+  }
+  unsigned int vertex( int index )const{
+    return vertices[( vertexOffset - 1 - index ) & ( VERTEX_FIFO_SIZE - 1 )];
+  }
+  void pushEdge( unsigned int a, unsigned int b ){
+    unsigned int * slot = edges[edgeOffset & ( EDGE_FIFO_SIZE - 1 )];
+    slot[0] = a;
+    slot[1] = b;
+    edgeOffset++;
+  }
+  void pushVertex( unsigned int v ){
+    vertices[vertexOffset & ( VERTEX_FIFO_SIZE - 1 )] = v;
+    vertexOffset++;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+size_t encodeIndexBufferBound( int indexCount ){
+  int triangleCount = indexCount / 3;
+  //code byte, miss byte and three 5 byte varints at worst
+  return 1 + triangleCount * 2 + triangleCount * 3 * 5;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned char * writeVarint( unsigned char * data, unsigned int value ){
+  while( value >= 0x80 ){
+    *data++ = (unsigned char)( value | 0x80 );
+    value >>= 7;
+  }
+  *data++ = (unsigned char)value;
+  return data;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int zigzag( unsigned int delta ){
+  return ( delta << 1 ) ^ ( 0u - ( delta >> 31 ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int unzigzag( unsigned int value ){
+  return ( value >> 1 ) ^ ( 0u - ( value & 1 ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+static int findEdge( const IndexCodecState & state, unsigned int a, unsigned int b ){
+  for( int i = 0; i < EDGE_FIFO_SIZE - 1; i++ ){
+    const unsigned int * edge = state.edge( i );
+    if( edge[0] == a && edge[1] == b )
+      return i;
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+static int findVertex( const IndexCodecState & state, unsigned int v ){
+  for( int i = 0; i < 14; i++ ){
+    if( state.vertex( i ) == v )
+      return i + 1;
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	picks the vertex nibble, explicit vertices go to the data stream
+//--------------------------------------------------------------------------------------------------
+static unsigned int encodeVertex( IndexCodecState & state, unsigned int v, unsigned char * & data ){
+  if( v == state.next ){
+    state.next++;
+    state.pushVertex( v );
+    return VERTEX_NEXT;
+  }
+  int fifoIndex = findVertex( state, v );
+  if( fifoIndex > 0 )
+    return fifoIndex;
+  data = writeVarint( data, zigzag( v - state.last ) );
+  state.last = v;
+  state.pushVertex( v );
+  return VERTEX_EXPLICIT;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t encodeIndexBuffer( unsigned char * buffer, size_t bufferSize, const unsigned int * indices, int indexCount ){
+  int triangleCount = indexCount / 3;
+  if( bufferSize < encodeIndexBufferBound( indexCount ) )
+    return 0;
+  IndexCodecState state;
+  state.reset();
+  buffer[0] = INDEX_HEADER | CHS_INDEX_CODEC_VERSION;
+  unsigned char * code = buffer + 1;
+  unsigned char * data = code + triangleCount;
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const unsigned int * corner = indices + triangle * 3;
+    int rotation = -1;
+    int edgeIndex = -1;
+    for( int k = 0; k < 3 && edgeIndex < 0; k++ ){
+      edgeIndex = findEdge( state, corner[k], corner[( k + 1 ) % 3] );
+      rotation = k;
+    }
+    if( edgeIndex >= 0 ){
+      unsigned int a = corner[rotation], b = corner[( rotation + 1 ) % 3], c = corner[( rotation + 2 ) % 3];
+      unsigned int vertexCode = encodeVertex( state, c, data );
+      *code++ = (unsigned char)( ( edgeIndex << 4 ) | vertexCode );
+      state.pushEdge( c, b );
+      state.pushEdge( a, c );
+    }
+    else{
+      unsigned int a = corner[0], b = corner[1], c = corner[2];
+      unsigned char * missByte = data++;
+      unsigned int codeA = encodeVertex( state, a, data );
+      unsigned int codeB = encodeVertex( state, b, data );
+      unsigned int codeC = encodeVertex( state, c, data );
+      *code++ = (unsigned char)( ( EDGE_MISS << 4 ) | codeA );
+      *missByte = (unsigned char)( ( codeB << 4 ) | codeC );
+      state.pushEdge( b, a );
+      state.pushEdge( c, b );
+      state.pushEdge( a, c );
+    }
+  }
+  return data - buffer;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	decoder side, every read is bounds checked against the buffer end
+//--------------------------------------------------------------------------------------------------
+static inline bool readVarint( const unsigned char * & data, const unsigned char * end, unsigned int & value ){
+  value = 0;
+  for( int shift = 0; shift < 35; shift += 7 ){
+    if( data == end )
+      return false;
+    unsigned char byte = *data++;
+    value |= (unsigned int)( byte & 0x7f ) << shift;
+    if( byte < 0x80 )
+      return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline bool decodeVertex( IndexCodecState & state, unsigned int vertexCode, const unsigned char * & data,
+                                 const unsigned char * end, unsigned int & v ){
+  if( vertexCode == VERTEX_NEXT ){
+    v = state.next++;
+    state.pushVertex( v );
+    return true;
+  }
+  if( vertexCode == VERTEX_EXPLICIT ){
+    unsigned int value;
+    if( !readVarint( data, end, value ) )
+      return false;
+    v = state.last + unzigzag( value );
+    state.last = v;
+    state.pushVertex( v );
+    return true;
+  }
+  v = state.vertex( vertexCode - 1 );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Index> int decodeTriangles( Index * destination, int triangleCount,
+                                               const unsigned char * buffer, size_t bufferSize ){
+  const unsigned char * end = buffer + bufferSize;
+  IndexCodecState state;
+  state.reset();
+  const unsigned char * code = buffer + 1;
+  const unsigned char * data = code + triangleCount;
+  if( data > end )
+    return -1;
+  for( int triangle = 0; triangle < triangleCount; triangle++, destination += 3 ){
+    unsigned int byte = *code++;
+    unsigned int edgeIndex = byte >> 4;
+    unsigned int a, b, c;
+    if( edgeIndex != EDGE_MISS ){
+      const unsigned int * edge = state.edge( edgeIndex );
+      a = edge[0];
+      b = edge[1];
+      if( !decodeVertex( state, byte & 15, data, end, c ) )
+        return -1;
+      state.pushEdge( c, b );
+      state.pushEdge( a, c );
+    }
+    else{
+      if( data == end )
+        return -1;
+      unsigned int second = *data++;
+      if( !decodeVertex( state, byte & 15, data, end, a ) ||
+          !decodeVertex( state, second >> 4, data, end, b ) ||
+          !decodeVertex( state, second & 15, data, end, c ) )
+        return -1;
+      state.pushEdge( b, a );
+      state.pushEdge( c, b );
+      state.pushEdge( a, c );
+    }
+    destination[0] = (Index)a;
+    destination[1] = (Index)b;
+    destination[2] = (Index)c;
+  }
+  return data == end ? 0 : -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+int decodeIndexBuffer( void * destination, int indexCount, int indexSize,
+                       const unsigned char * buffer, size_t bufferSize ){
+  if( bufferSize < 1 || buffer[0] != ( INDEX_HEADER | CHS_INDEX_CODEC_VERSION ) || indexCount % 3 )
+    return -1;
+  if( indexSize == 2 )
+    return decodeTriangles( static_cast<unsigned short *>( destination ), indexCount / 3, buffer, bufferSize );
+  if( indexSize == 4 )
+    return decodeTriangles( static_cast<unsigned int *>( destination ), indexCount / 3, buffer, bufferSize );
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
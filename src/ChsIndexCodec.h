@@ -0,0 +1,27 @@
+#ifndef _CHSINDEXCODEC_H
+#define _CHSINDEXCODEC_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+
+//--------------------------------------------------------------------------------------------------
+//	Triangle list codec after meshoptimizer's index codec, self contained so the runtime can take
+//	the decoder as is. One code byte per triangle names a recently seen edge and where the third
+//	vertex comes from: the next unused index, a recent vertex, or an explicit zigzag varint delta.
+//	Works best on cache and fetch optimized lists, about one byte per triangle. Triangles may come
+//	back rotated, never reordered or flipped.
+//--------------------------------------------------------------------------------------------------
+enum{
+  CHS_INDEX_CODEC_VERSION = 1,
+};
+
+//--------------------------------------------------------------------------------------------------
+size_t encodeIndexBufferBound( int indexCount );
+//returns the encoded size, 0 when buffer is too small
+size_t encodeIndexBuffer( unsigned char * buffer, size_t bufferSize, const unsigned int * indices, int indexCount );
+//indexSize is 2 or 4, returns 0 on success, -1 on malformed input
+int decodeIndexBuffer( void * destination, int indexCount, int indexSize,
+                       const unsigned char * buffer, size_t bufferSize );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSINDEXCODEC_H
@@ -0,0 +1,185 @@
+#include <string.h>
+#include <vector>
+
+#include "ChsLz4.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Sequence: token ( literal length high nibble, match length - 4 low nibble ), length bytes
+//	when a nibble is 15, literals, 2 byte little endian offset, match length bytes. The last
+//	sequence has literals only, the last match starts 12 bytes and ends 5 bytes before the end.
+//--------------------------------------------------------------------------------------------------
+enum{
+  MIN_MATCH = 4,
+  LAST_LITERALS = 5,
+  MATCH_FIND_LIMIT = 12,
+  MAX_OFFSET = 65535,
+  HASH_BITS = 16,
+  SKIP_TRIGGER = 6,
+};
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int read32( const unsigned char * p ){
+  unsigned int value;
+  memcpy( &value, p, sizeof( value ) );
+  return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int hash32( unsigned int value ){
+  return ( value * 2654435761u ) >> ( 32 - HASH_BITS );
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned char * writeLength( unsigned char * op, size_t length ){
+  while( length >= 255 ){
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (unsigned char)length;
+  return op;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t lz4CompressBound( size_t size ){
+  return size + size / 255 + 16;
+}
+
+//--------------------------------------------------------------------------------------------------
+static unsigned char * writeSequence( unsigned char * op, const unsigned char * opEnd,
+                                      const unsigned char * literals, size_t literalLength,
+                                      size_t offset, size_t matchLength ){
+  //token, literals with their length bytes, offset and match length bytes at worst
+  if( (size_t)( opEnd - op ) < 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1 )
+    return NULL;
+  unsigned char * token = op++;
+  *token = (unsigned char)( ( literalLength < 15 ? literalLength : 15 ) << 4 );
+  if( literalLength >= 15 )
+    op = writeLength( op, literalLength - 15 );
+  memcpy( op, literals, literalLength );
+  op += literalLength;
+  if( offset == 0 )
+    return op;
+  *op++ = (unsigned char)offset;
+  *op++ = (unsigned char)( offset >> 8 );
+  matchLength -= MIN_MATCH;
+  *token |= (unsigned char)( matchLength < 15 ? matchLength : 15 );
+  if( matchLength >= 15 )
+    op = writeLength( op, matchLength - 15 );
+  return op;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t lz4Compress( unsigned char * destination, size_t capacity, const unsigned char * source, size_t size ){
+  const unsigned char * ip = source;
+  const unsigned char * anchor = source;
+  const unsigned char * end = source + size;
+  unsigned char * op = destination;
+  const unsigned char * opEnd = destination + capacity;
+  if( size > MATCH_FIND_LIMIT ){
+    const unsigned char * matchFindLimit = end - MATCH_FIND_LIMIT;
+    const unsigned char * matchLimit = end - LAST_LITERALS;
+    std::vector<unsigned int> table( 1 << HASH_BITS, 0 );
+    ip++;
+    while( ip <= matchFindLimit ){
+      //search, stepping faster through data that does not match
+      const unsigned char * match = NULL;
+      unsigned int attempts = 1 << SKIP_TRIGGER;
+      while( ip <= matchFindLimit ){
+        unsigned int sequence = read32( ip );
+        unsigned int & entry = table[hash32( sequence )];
+        match = source + entry;
+        entry = ip - source;
+        if( match < ip && ip - match <= MAX_OFFSET && read32( match ) == sequence )
+          break;
+        match = NULL;
+        ip += attempts++ >> SKIP_TRIGGER;
+      }
+      if( match == NULL )
+        break;
+      while( ip > anchor && match > source && ip[-1] == match[-1] ){
+        ip--;
+        match--;
+      }
+      const unsigned char * matchEnd = ip + MIN_MATCH;
+      const unsigned char * reference = match + MIN_MATCH;
+      while( matchEnd < matchLimit && *matchEnd == *reference ){
+        matchEnd++;
+        reference++;
+      }
+      op = writeSequence( op, opEnd, anchor, ip - anchor, ip - match, matchEnd - ip );
+      if( op == NULL )
+        return 0;
+      if( matchEnd - 2 > ip )
+        table[hash32( read32( matchEnd - 2 ) )] = matchEnd - 2 - source;
+      ip = anchor = matchEnd;
+    }
+  }
+  op = writeSequence( op, opEnd, anchor, end - anchor, 0, 0 );
+  if( op == NULL )
+    return 0;
+  return op - destination;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline bool readLength( const unsigned char * & ip, const unsigned char * end, size_t & length ){
+  unsigned char byte;
+  do{
+    if( ip == end )
+      return false;
+    byte = *ip++;
+    length += byte;
+  }while( byte == 255 );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+int lz4Decompress( unsigned char * destination, size_t capacity, const unsigned char * source, size_t size ){
+  const unsigned char * ip = source;
+  const unsigned char * end = source + size;
+  unsigned char * op = destination;
+  unsigned char * opEnd = destination + capacity;
+  while( ip < end ){
+    unsigned int token = *ip++;
+    size_t literalLength = token >> 4;
+    if( literalLength == 15 && !readLength( ip, end, literalLength ) )
+      return -1;
+    if( literalLength > (size_t)( end - ip ) || literalLength > (size_t)( opEnd - op ) )
+      return -1;
+    memcpy( op, ip, literalLength );
+    ip += literalLength;
+    op += literalLength;
+    if( ip == end )
+      break;
+    if( end - ip < 2 )
+      return -1;
+    size_t offset = ip[0] | ( ip[1] << 8 );
+    ip += 2;
+    if( offset == 0 || offset > (size_t)( op - destination ) )
+      return -1;
+    size_t matchLength = token & 15;
+    if( matchLength == 15 && !readLength( ip, end, matchLength ) )
+      return -1;
+    matchLength += MIN_MATCH;
+    if( matchLength > (size_t)( opEnd - op ) )
+      return -1;
+    const unsigned char * match = op - offset;
+    if( offset >= 8 && (size_t)( opEnd - op ) >= matchLength + 8 ){
+      //8 byte copies may run past the match end, they stay inside the output
+      unsigned char * copyEnd = op + matchLength;
+      do{
+        memcpy( op, match, 8 );
+        op += 8;
+        match += 8;
+      }while( op < copyEnd );
+      op = copyEnd;
+    }
+    else{
+      for( size_t i = 0; i < matchLength; i++ )
+        op[i] = match[i];
+      op += matchLength;
+    }
+  }
+  return op - destination;
+}
+
+//--------------------------------------------------------------------------------------------------
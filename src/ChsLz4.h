@@ -0,0 +1,19 @@
+#ifndef _CHSLZ4_H
+#define _CHSLZ4_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+
+//--------------------------------------------------------------------------------------------------
+//	LZ4 block format, written here so the plugin needs no extra library. Any LZ4 block decoder
+//	( LZ4_decompress_safe ) reads the output, the decoder below reads any LZ4 block. The
+//	compressor is the greedy single hash one, fast rather than tight.
+//--------------------------------------------------------------------------------------------------
+size_t lz4CompressBound( size_t size );
+//returns the compressed size, 0 when the block does not fit into capacity
+size_t lz4Compress( unsigned char * destination, size_t capacity, const unsigned char * source, size_t size );
+//returns the decompressed size, -1 on malformed input or when it would overrun capacity
+int lz4Decompress( unsigned char * destination, size_t capacity, const unsigned char * source, size_t size );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSLZ4_H
@@ -0,0 +1,236 @@
+#ifndef _CHSMESH_H
+#define _CHSMESH_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+#include <string>
+#include <limits.h>
+#include <float.h>
+#include <boost/shared_ptr.hpp>
+
+//--------------------------------------------------------------------------------------------------
+//	A range of the mesh buffers drawn on its own, indices are relative to firstVertex.
+//	material indexes ChsMesh::materials; submeshes of one material list are contiguous.
+//--------------------------------------------------------------------------------------------------
+struct ChsSubmesh{
+  int firstVertex;
+  int vertexCount;
+  int firstIndex;
+  int indexCount;
+  int material;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Small cluster of a submesh for cpu side culling.
+//	vertexOffset indexes meshletVertices, which hold vertex buffer indices, triangleOffset is the
+//	byte offset of 3 * triangleCount local indices in meshletTriangles.
+//	The cluster is back facing for a camera at c when dot( normalize( coneApex - c ), coneAxis )
+//	>= coneCutoff; a cutoff of 1 never culls.
+//--------------------------------------------------------------------------------------------------
+struct ChsMeshlet{
+  unsigned int submesh;
+  unsigned int vertexOffset;
+  unsigned int vertexCount;
+  unsigned int triangleOffset;
+  unsigned int triangleCount;
+  float center[3];
+  float radius;
+  float coneApex[3];
+  float coneAxis[3];
+  float coneCutoff;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Extra index buffer over the shared vertex buffer, ranges follow the mesh submeshes
+//--------------------------------------------------------------------------------------------------
+struct ChsLod{
+  float ratio;
+  float error;
+  std::vector<unsigned int> indices;
+  std::vector<ChsSubmesh> submeshes;
+  std::vector<unsigned char> encodedIndices;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Triangles a static batch took from one source mesh, for picking
+//--------------------------------------------------------------------------------------------------
+struct ChsBatchRange{
+  std::string meshName;
+  int firstIndex;
+  int indexCount;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Values read from a shading group, one entry per exported material channel
+//--------------------------------------------------------------------------------------------------
+struct ChsMaterialChannelValue{
+  std::string textureFileName;
+  double r, g, b;
+};
+
+struct ChsMeshMaterial{
+  std::vector<ChsMaterialChannelValue> channels;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	One attribute of the encoded vertex, offset is in bytes from the start of the vertex inside
+//	its stream. Streams are blocks of vertexData, each with a vertex stride of its own.
+//	Integer types with normalized set map to [0,1] or [-1,1] like glVertexAttribPointer does.
+//--------------------------------------------------------------------------------------------------
+enum ChsVertexAttributeId{
+  CHS_ATTRIBUTE_POSITION,
+  CHS_ATTRIBUTE_NORMAL,
+  CHS_ATTRIBUTE_TEXCOORD0,
+  CHS_ATTRIBUTE_COLOR,
+  CHS_ATTRIBUTE_TANGENT,
+  CHS_ATTRIBUTE_MAX,
+};
+
+enum ChsVertexAttributeType{
+  CHS_TYPE_FLOAT,
+  CHS_TYPE_HALF_FLOAT,
+  CHS_TYPE_UNSIGNED_SHORT,
+  CHS_TYPE_SHORT,
+  CHS_TYPE_UNSIGNED_BYTE,
+  CHS_TYPE_BYTE,
+  CHS_TYPE_MAX,
+};
+
+struct ChsVertexAttribute{
+  int id;
+  int components;
+  int type;
+  bool normalized;
+  int offset;
+  int stream;
+};
+
+struct ChsVertexStream{
+  int offset;   //bytes from the start of vertexData
+  int stride;
+};
+
+//--------------------------------------------------------------------------------------------------
+struct ChsMesh{
+  std::string name;
+  bool isShort;
+  bool hasVertexColor;
+  bool hasUV;
+  bool hasTexture;
+  bool hasTangent;
+  bool isAnimated;
+  bool hasAnimatedTransform;  //only looked up for static batching, keeps the mesh out of batches
+  std::vector<float> vertexArray;
+  //what actually gets written, filled from vertexArray by encodeMeshVertices
+  std::vector<ChsVertexAttribute> attributes;
+  std::vector<ChsVertexStream> streams;
+  int vertexSize;           //bytes per vertex over all streams
+  std::vector<unsigned char> vertexData;
+  //vertex codec streams, one per vertex stream, each as uint32 size, data, padding to 4 bytes
+  std::vector<unsigned char> encodedVertexData;
+  bool isQuantized;
+  float positionScale[3];   //quantized position = offset + normalized value * scale
+  float positionOffset[3];
+  std::vector<unsigned short> usIndexArray;
+  std::vector<unsigned int> uiIndexArray;
+  //index codec streams, one per submesh, each as uint32 size, data, padding to 4 bytes
+  std::vector<unsigned char> encodedIndexArray;
+  //geometry codec streams in place of both, one per vertex range holding the index lists of its
+  //submeshes in submesh order, each as uint32 size, data, padding to 4 bytes
+  std::vector<unsigned char> encodedGeometry;
+  std::vector<ChsSubmesh> submeshes;
+  std::vector<ChsMeshlet> meshlets;
+  std::vector<unsigned int> meshletVertices;
+  std::vector<unsigned char> meshletTriangles;
+  std::vector<ChsLod> lods;
+  //optional position only copy for depth passes, empty unless built; positions have the type and
+  //scale of the main stream position attribute, depthPositionSize bytes each
+  std::vector<unsigned char> depthPositions;
+  int depthPositionSize;
+  std::vector<unsigned int> depthIndices;
+  std::vector<ChsMeshMaterial> materials;
+  std::vector<ChsBatchRange> batchRanges;   //only set on static batches
+  float transform[4][4];
+  
+  ChsMesh( void ) : isShort( true ), hasVertexColor( false ), hasUV( false ),
+                    hasTexture( false ), hasTangent( false ), isAnimated( false ),
+                    hasAnimatedTransform( false ), vertexSize( 0 ), isQuantized( false ),
+                    depthPositionSize( 0 ){}
+  
+  //floats per vertex in vertexArray, position3 normal3 [texcoord2] [color4] [tangent4]
+  int vertexStride( void )const{
+    return 6 + ( ( hasUV && hasTexture ) ? 2 : 0 ) + ( hasVertexColor ? 4 : 0 ) + ( hasTangent ? 4 : 0 );
+  }
+  
+  int vertexCount( void )const{
+    return vertexArray.size() / vertexStride();
+  }
+  
+  int indexCount( void )const{
+    return isShort ? usIndexArray.size() : uiIndexArray.size();
+  }
+  
+  int depthVertexCount( void )const{
+    return depthPositionSize > 0 ? depthPositions.size() / depthPositionSize : 0;
+  }
+  
+  bool isDepthShort( void )const{
+    return depthVertexCount() <= USHRT_MAX;
+  }
+  
+  void getIndexArray( std::vector<unsigned int> & indices )const{
+    if( isShort )
+      indices.assign( usIndexArray.begin(), usIndexArray.end() );
+    else
+      indices.assign( uiIndexArray.begin(), uiIndexArray.end() );
+  }
+  
+  //bytes of the vertex, index and derived buffers, what a mesh waiting to be written holds
+  size_t memorySize( void )const{
+    size_t size = vertexArray.size() * sizeof( float ) + vertexData.size() + encodedVertexData.size() +
+                  usIndexArray.size() * sizeof( unsigned short ) + uiIndexArray.size() * sizeof( unsigned int ) +
+                  encodedIndexArray.size() + encodedGeometry.size() + meshlets.size() * sizeof( ChsMeshlet ) +
+                  meshletVertices.size() * sizeof( unsigned int ) + meshletTriangles.size() +
+                  depthPositions.size() + depthIndices.size() * sizeof( unsigned int );
+    for( size_t i = 0; i < lods.size(); i++ )
+      size += lods[i].indices.size() * sizeof( unsigned int ) + lods[i].encodedIndices.size();
+    return size;
+  }
+  
+  //box of the vertexArray positions, min above max for a mesh without vertices
+  void getBounds( float boundsMin[3], float boundsMax[3] )const{
+    for( int c = 0; c < 3; c++ ){
+      boundsMin[c] = FLT_MAX;
+      boundsMax[c] = -FLT_MAX;
+    }
+    int stride = vertexStride();
+    for( size_t i = 0; i + stride <= vertexArray.size(); i += stride ){
+      for( int c = 0; c < 3; c++ ){
+        boundsMin[c] = vertexArray[i + c] < boundsMin[c] ? vertexArray[i + c] : boundsMin[c];
+        boundsMax[c] = vertexArray[i + c] > boundsMax[c] ? vertexArray[i + c] : boundsMax[c];
+      }
+    }
+  }
+  
+  //picks the index width from the largest vertex range the indices address
+  void setIndexArray( const std::vector<unsigned int> & indices ){
+    usIndexArray.clear();
+    uiIndexArray.clear();
+    int maxVertexCount = submeshes.empty() ? vertexCount() : 0;
+    for( size_t i = 0; i < submeshes.size(); i++ ){
+      if( submeshes[i].vertexCount > maxVertexCount )
+        maxVertexCount = submeshes[i].vertexCount;
+    }
+    isShort = maxVertexCount <= USHRT_MAX;
+    if( isShort )
+      usIndexArray.assign( indices.begin(), indices.end() );
+    else
+      uiIndexArray.assign( indices.begin(), indices.end() );
+  }
+  
+};
+
+typedef boost::shared_ptr<ChsMesh> ChsMeshSharedPtr;
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESH_H
@@ -0,0 +1,226 @@
+#include <algorithm>
+
+#include "ChsMeshBuilder.h"
+#include "ChsVertexWelder.h"
+
+//--------------------------------------------------------------------------------------------------
+struct VertexUnit{
+  int vertexId;
+  int normalId;
+  int uvId;
+};
+
+static ChsVertexWelder< VertexUnit > vertexWelder;
+static std::vector<int> cornerIndices;
+static std::vector<int> triangleCorners;
+
+//--------------------------------------------------------------------------------------------------
+void makeIndexData( const ChsMeshData & meshData, ChsMeshSharedPtr & mesh ){
+  int numFaceVertices = meshData.numFaceVertices();
+  vertexWelder.reset( numFaceVertices );
+  bool weldUV = mesh->hasUV && mesh->hasTexture;
+  cornerIndices.resize( numFaceVertices );
+  for( int faceVertex = 0; faceVertex < numFaceVertices; faceVertex++ ){
+    VertexUnit unit = {
+      meshData.vertexIds[faceVertex],
+      meshData.normalIds[faceVertex],
+      weldUV ? meshData.uvIds[faceVertex] : -1,
+    };
+    cornerIndices[faceVertex] = vertexWelder.weld( unit );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	corners of a polygon that lists the same vertex twice can not be told apart by vertex id
+//--------------------------------------------------------------------------------------------------
+bool hasRepeatedVertex( const ChsMeshData & meshData, int firstCorner, int cornerCount ){
+  for( int i = 1; i < cornerCount; i++ ){
+    for( int j = 0; j < i; j++ ){
+      if( meshData.vertexIds[firstCorner + i] == meshData.vertexIds[firstCorner + j] )
+        return true;
+    }
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	triangleVertices hold object vertex ids, maps each back to the corner of its polygon that uses
+//	that vertex, false when one is not a corner of the polygon
+//--------------------------------------------------------------------------------------------------
+bool findTriangleCorners( const ChsMeshData & meshData, int firstCorner, int cornerCount,
+                          int firstTriangleVertex, int triangleCount ){
+  triangleCorners.resize( triangleCount * 3 );
+  for( int i = 0; i < triangleCount * 3; i++ ){
+    int vertexId = meshData.triangleVertices[firstTriangleVertex + i];
+    triangleCorners[i] = -1;
+    for( int corner = 0; corner < cornerCount && triangleCorners[i] < 0; corner++ ){
+      if( meshData.vertexIds[firstCorner + corner] == vertexId )
+        triangleCorners[i] = firstCorner + corner;
+    }
+    if( triangleCorners[i] < 0 )
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	welded indices of the source triangulation, polygons it does not map back to are fanned,
+//	returns how many were
+//--------------------------------------------------------------------------------------------------
+int makeTriangleData( const ChsMeshData & meshData, std::vector<unsigned int> & indices,
+                      std::vector<int> & triangleMaterials ){
+  int numPolygons = meshData.polygonCounts.size();
+  bool hasMaterials = !meshData.polygonMaterials.empty();
+  triangleMaterials.clear();
+  bool hasTriangles = !meshData.triangleCounts.empty();
+  indices.clear();
+  indices.reserve( hasTriangles ? meshData.triangleVertices.size() : meshData.numFaceVertices() * 3 );
+  int firstCorner = 0;
+  int triangleVertex = 0;
+  int fannedCount = 0;
+  for( int polygonId = 0; polygonId < numPolygons; polygonId++ ){
+    int cornerCount = meshData.polygonCounts[polygonId];
+    int material = hasMaterials ? meshData.polygonMaterials[polygonId] : 0;
+    int triangleCount = hasTriangles ? meshData.triangleCounts[polygonId] : 0;
+    bool isMapped = hasTriangles && !hasRepeatedVertex( meshData, firstCorner, cornerCount ) &&
+                    findTriangleCorners( meshData, firstCorner, cornerCount, triangleVertex, triangleCount );
+    if( isMapped ){
+      for( int i = 0; i < triangleCount * 3; i += 3 ){
+        indices.push_back( cornerIndices[triangleCorners[i]] );
+        indices.push_back( cornerIndices[triangleCorners[i + 1]] );
+        indices.push_back( cornerIndices[triangleCorners[i + 2]] );
+        triangleMaterials.push_back( material );
+      }
+    }
+    else{
+      //no triangulation from the source or one that does not match the corners, fan the polygon
+      fannedCount += hasTriangles ? 1 : 0;
+      for( int corner = 1; corner + 1 < cornerCount; corner++ ){
+        indices.push_back( cornerIndices[firstCorner] );
+        indices.push_back( cornerIndices[firstCorner + corner] );
+        indices.push_back( cornerIndices[firstCorner + corner + 1] );
+        triangleMaterials.push_back( material );
+      }
+    }
+    firstCorner += cornerCount;
+    triangleVertex += triangleCount * 3;
+  }
+  return fannedCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Vertex assembly kernels, one instantiation per attribute layout. The layout is a mask of the
+//	optional attributes after position and normal, in the order they are stored.
+//--------------------------------------------------------------------------------------------------
+enum{
+  VERTEX_LAYOUT_UV = 1,
+  VERTEX_LAYOUT_COLOR = 2,
+};
+
+template <int Layout> struct VertexLayout{
+  enum{
+    HAS_UV = ( Layout & VERTEX_LAYOUT_UV ) != 0,
+    HAS_COLOR = ( Layout & VERTEX_LAYOUT_COLOR ) != 0,
+    STRIDE = 6 + HAS_UV * 2 + HAS_COLOR * 4,
+  };
+};
+
+//--------------------------------------------------------------------------------------------------
+template <int Layout> void writeVertices( const ChsMeshData & meshData, const VertexUnit * units,
+                                          int unitCount, float * dest ){
+  typedef VertexLayout<Layout> Traits;
+  static const float noUV[2] = { 0.0f, 0.0f };
+  for( int i = 0; i < unitCount; i++, dest += Traits::STRIDE ){
+    const VertexUnit & unit = units[i];
+    const float * pos = &meshData.points[unit.vertexId * 3];
+    const float * normal = &meshData.normals[unit.normalId * 3];
+    dest[0] = pos[0];
+    dest[1] = pos[1];
+    dest[2] = pos[2];
+    dest[3] = normal[0];
+    dest[4] = normal[1];
+    dest[5] = normal[2];
+    int offset = 6;
+    if( Traits::HAS_UV ){
+      const float * uv = unit.uvId >= 0 ? &meshData.uvs[unit.uvId * 2] : noUV;
+      dest[offset] = uv[0];
+      dest[offset + 1] = uv[1];
+      offset += 2;
+    }
+    if( Traits::HAS_COLOR ){
+      const float * color = &meshData.colors[unit.vertexId * 4];
+      dest[offset] = color[0];
+      dest[offset + 1] = color[1];
+      dest[offset + 2] = color[2];
+      dest[offset + 3] = color[3];
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeVertexData( const ChsMeshData & meshData, ChsMeshSharedPtr & mesh ){
+  typedef void (*VertexWriter)( const ChsMeshData &, const VertexUnit *, int, float * );
+  static const VertexWriter writers[] = {
+    writeVertices<0>,
+    writeVertices<VERTEX_LAYOUT_UV>,
+    writeVertices<VERTEX_LAYOUT_COLOR>,
+    writeVertices<VERTEX_LAYOUT_UV | VERTEX_LAYOUT_COLOR>,
+  };
+  int layout = ( ( mesh->hasUV && mesh->hasTexture ) ? VERTEX_LAYOUT_UV : 0 ) |
+               ( mesh->hasVertexColor ? VERTEX_LAYOUT_COLOR : 0 );
+  const std::vector< VertexUnit > & units = vertexWelder.units();
+  int unitCount = units.size();
+  mesh->vertexArray.resize( unitCount * mesh->vertexStride() );
+  if( unitCount > 0 )
+    writers[layout]( meshData, units.data(), unitCount, mesh->vertexArray.data() );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	groups the triangles by material, keeping their order inside a group, one submesh per used
+//	material over the whole vertex buffer
+//--------------------------------------------------------------------------------------------------
+void makeSubmeshData( const std::vector<int> & triangleMaterials, std::vector<unsigned int> & indices,
+                      ChsMeshSharedPtr & mesh ){
+  int materialCount = 1;
+  for( size_t i = 0; i < triangleMaterials.size(); i++ )
+    materialCount = std::max( materialCount, triangleMaterials[i] + 1 );
+  std::vector<int> firstTriangle( materialCount + 1, 0 );
+  for( size_t i = 0; i < triangleMaterials.size(); i++ )
+    firstTriangle[triangleMaterials[i] + 1]++;
+  for( int material = 0; material < materialCount; material++ )
+    firstTriangle[material + 1] += firstTriangle[material];
+  mesh->submeshes.clear();
+  for( int material = 0; material < materialCount; material++ ){
+    int triangleCount = firstTriangle[material + 1] - firstTriangle[material];
+    if( triangleCount == 0 && materialCount > 1 )
+      continue;
+    ChsSubmesh submesh = { 0, mesh->vertexCount(), firstTriangle[material] * 3, triangleCount * 3, material };
+    mesh->submeshes.push_back( submesh );
+  }
+  if( materialCount == 1 )
+    return;
+  std::vector<unsigned int> grouped( indices.size() );
+  std::vector<int> fill( firstTriangle.begin(), firstTriangle.end() - 1 );
+  for( size_t triangle = 0; triangle < triangleMaterials.size(); triangle++ ){
+    int target = fill[triangleMaterials[triangle]]++;
+    for( int k = 0; k < 3; k++ )
+      grouped[target * 3 + k] = indices[triangle * 3 + k];
+  }
+  indices.swap( grouped );
+}
+
+//--------------------------------------------------------------------------------------------------
+int buildMesh( const ChsMeshData & meshData, ChsMeshSharedPtr & mesh ){
+  mesh->hasUV = !meshData.uvs.empty();
+  mesh->hasVertexColor = !meshData.colors.empty();
+  makeIndexData( meshData, mesh );
+  makeVertexData( meshData, mesh );
+  std::vector<unsigned int> indices;
+  std::vector<int> triangleMaterials;
+  int fannedCount = makeTriangleData( meshData, indices, triangleMaterials );
+  makeSubmeshData( triangleMaterials, indices, mesh );
+  mesh->setIndexArray( indices );
+  return fannedCount;
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,15 @@
+#ifndef _CHSMESHBUILDER_H
+#define _CHSMESHBUILDER_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+#include "ChsMeshData.h"
+
+//--------------------------------------------------------------------------------------------------
+//	returns how many polygons were fanned because their triangles did not map back to their
+//	corners ( a vertex id that is not a corner, or one listed twice ), zero when all did
+//--------------------------------------------------------------------------------------------------
+int buildMesh( const ChsMeshData & meshData, ChsMeshSharedPtr & mesh );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHBUILDER_H
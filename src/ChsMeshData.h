@@ -0,0 +1,49 @@
+#ifndef _CHSMESHDATA_H
+#define _CHSMESHDATA_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//	Plain copy of everything the exporter reads from a mesh, pulled in one pass per mesh.
+//	The builder only ever looks at these arrays, so anything that fills them (the Maya gather
+//	stage or a stand-in source on a machine without Maya) can drive the export code.
+//--------------------------------------------------------------------------------------------------
+struct ChsMeshData{
+  std::vector<float> points;          //x y z per vertex, object space
+  std::vector<float> normals;         //x y z per normal
+  std::vector<float> uvs;             //u v per uv, empty if the mesh has no uv
+  std::vector<float> colors;          //r g b a per vertex, empty if the mesh has no color
+  std::vector<int> polygonCounts;     //corner count per polygon
+  std::vector<int> vertexIds;         //per face-vertex
+  std::vector<int> normalIds;         //per face-vertex
+  std::vector<int> uvIds;             //per face-vertex, -1 where unmapped
+  std::vector<int> triangleCounts;    //triangle count per polygon
+  std::vector<int> triangleVertices;  //three vertex ids per triangle
+  std::vector<int> polygonMaterials;  //material index per polygon, empty if all use material 0
+
+  void clear( void ){
+    points.clear();
+    normals.clear();
+    uvs.clear();
+    colors.clear();
+    polygonCounts.clear();
+    vertexIds.clear();
+    normalIds.clear();
+    uvIds.clear();
+    triangleCounts.clear();
+    triangleVertices.clear();
+    polygonMaterials.clear();
+  }
+  
+  int numVertices( void )const{
+    return points.size() / 3;
+  }
+  
+  int numFaceVertices( void )const{
+    return vertexIds.size();
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHDATA_H
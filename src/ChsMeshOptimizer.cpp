@@ -0,0 +1,289 @@
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "ChsMeshOptimizer.h"
+
+//--------------------------------------------------------------------------------------------------
+//	a vertex is in the FIFO cache while fewer than cacheSize misses happened since it was loaded
+//--------------------------------------------------------------------------------------------------
+static void simulateVertexCache( const unsigned int * indices, int indexCount, int vertexCount, int cacheSize,
+                                 int & misses, int & referencedCount ){
+  std::vector<int> loadTime( vertexCount, -cacheSize - 1 );
+  std::vector<bool> referenced( vertexCount, false );
+  int time = 0;
+  for( int i = 0; i < indexCount; i++ ){
+    unsigned int vertex = indices[i];
+    if( time - loadTime[vertex] > cacheSize ){
+      loadTime[vertex] = ++time;
+    }
+    if( !referenced[vertex] ){
+      referenced[vertex] = true;
+      referencedCount++;
+    }
+  }
+  misses += time;
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsVertexCacheStats analyzeVertexCache( const unsigned int * indices, int indexCount, int vertexCount,
+                                        int cacheSize ){
+  ChsVertexCacheStats stats = { 0.0f, 0.0f };
+  if( indexCount < 3 || vertexCount <= 0 )
+    return stats;
+  int misses = 0, referencedCount = 0;
+  simulateVertexCache( indices, indexCount, vertexCount, cacheSize, misses, referencedCount );
+  stats.acmr = (float)misses / ( indexCount / 3 );
+  stats.atvr = (float)misses / referencedCount;
+  return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Forsyth, "Linear-Speed Vertex Cache Optimisation"
+//--------------------------------------------------------------------------------------------------
+enum{
+  FORSYTH_CACHE_SIZE = 32,
+  FORSYTH_MAX_VALENCE = 32,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	filled during static initialization, so concurrent optimizations only ever read them
+//--------------------------------------------------------------------------------------------------
+struct ForsythScoreTables{
+  float cacheScore[FORSYTH_CACHE_SIZE];
+  float valenceScore[FORSYTH_MAX_VALENCE + 1];
+  
+  ForsythScoreTables( void ){
+    const float lastTriangleScore = 0.75f;
+    const float cacheDecayPower = 1.5f;
+    const float valenceBoostScale = 2.0f;
+    const float valenceBoostPower = 0.5f;
+    for( int position = 0; position < FORSYTH_CACHE_SIZE; position++ ){
+      if( position < 3 ){
+        cacheScore[position] = lastTriangleScore;
+      }
+      else{
+        float scaler = 1.0f / ( FORSYTH_CACHE_SIZE - 3 );
+        cacheScore[position] = powf( 1.0f - ( position - 3 ) * scaler, cacheDecayPower );
+      }
+    }
+    valenceScore[0] = 0.0f;
+    for( int valence = 1; valence <= FORSYTH_MAX_VALENCE; valence++ )
+      valenceScore[valence] = valenceBoostScale * powf( (float)valence, -valenceBoostPower );
+  }
+};
+
+static const ForsythScoreTables scoreTables;
+
+//--------------------------------------------------------------------------------------------------
+static float vertexScore( int cachePosition, int remainingValence ){
+  if( remainingValence == 0 )
+    return -1.0f;
+  float score = cachePosition >= 0 ? scoreTables.cacheScore[cachePosition] : 0.0f;
+  score += scoreTables.valenceScore[remainingValence < FORSYTH_MAX_VALENCE ? remainingValence : FORSYTH_MAX_VALENCE];
+  return score;
+}
+
+//--------------------------------------------------------------------------------------------------
+void optimizeVertexCache( unsigned int * indices, int indexCount, int vertexCount ){
+  int triangleCount = indexCount / 3;
+  if( triangleCount < 2 )
+    return;
+  //vertex to triangle adjacency
+  std::vector<int> valence( vertexCount, 0 );
+  for( int i = 0; i < indexCount; i++ )
+    valence[indices[i]]++;
+  std::vector<int> adjacencyOffset( vertexCount + 1, 0 );
+  for( int vertex = 0; vertex < vertexCount; vertex++ )
+    adjacencyOffset[vertex + 1] = adjacencyOffset[vertex] + valence[vertex];
+  std::vector<int> adjacency( indexCount );
+  std::vector<int> fill( adjacencyOffset.begin(), adjacencyOffset.end() - 1 );
+  for( int i = 0; i < indexCount; i++ )
+    adjacency[fill[indices[i]]++] = i / 3;
+
+  std::vector<int> cachePosition( vertexCount, -1 );
+  std::vector<float> score( vertexCount );
+  for( int vertex = 0; vertex < vertexCount; vertex++ )
+    score[vertex] = vertexScore( -1, valence[vertex] );
+  std::vector<float> triangleScore( triangleCount );
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const unsigned int * corner = &indices[triangle * 3];
+    triangleScore[triangle] = score[corner[0]] + score[corner[1]] + score[corner[2]];
+  }
+  std::vector<bool> isEmitted( triangleCount, false );
+  std::vector<unsigned int> output;
+  output.reserve( indexCount );
+
+  int cache[FORSYTH_CACHE_SIZE + 3];
+  int cacheCount = 0;
+  int bestTriangle = 0;
+  int inputCursor = 0;
+  for( int emitted = 0; emitted < triangleCount; emitted++ ){
+    if( bestTriangle < 0 ){
+      //nothing adjacent to the cache is left, take the next unused input triangle
+      while( isEmitted[inputCursor] )
+        inputCursor++;
+      bestTriangle = inputCursor;
+    }
+    isEmitted[bestTriangle] = true;
+    const unsigned int * corner = &indices[bestTriangle * 3];
+    output.insert( output.end(), corner, corner + 3 );
+
+    //push the triangle's vertices to the cache front and drop its adjacency entries
+    int newCache[FORSYTH_CACHE_SIZE + 3];
+    int newCount = 0;
+    for( int k = 0; k < 3; k++ ){
+      int vertex = corner[k];
+      newCache[newCount++] = vertex;
+      int begin = adjacencyOffset[vertex];
+      int end = begin + valence[vertex];
+      for( int i = begin; i < end; i++ ){
+        if( adjacency[i] == bestTriangle ){
+          adjacency[i] = adjacency[end - 1];
+          break;
+        }
+      }
+      valence[vertex]--;
+    }
+    for( int i = 0; i < cacheCount; i++ ){
+      int vertex = cache[i];
+      if( vertex != (int)corner[0] && vertex != (int)corner[1] && vertex != (int)corner[2] )
+        newCache[newCount++] = vertex;
+    }
+    cacheCount = newCount;
+    for( int i = 0; i < cacheCount; i++ )
+      cache[i] = newCache[i];
+
+    //rescore the cached vertices and pick the best triangle touching them
+    for( int i = 0; i < cacheCount; i++ ){
+      int vertex = cache[i];
+      cachePosition[vertex] = i < FORSYTH_CACHE_SIZE ? i : -1;
+      float newScore = vertexScore( cachePosition[vertex], valence[vertex] );
+      float delta = newScore - score[vertex];
+      score[vertex] = newScore;
+      int begin = adjacencyOffset[vertex];
+      for( int j = begin; j < begin + valence[vertex]; j++ )
+        triangleScore[adjacency[j]] += delta;
+    }
+    bestTriangle = -1;
+    float bestScore = -1.0f;
+    for( int i = 0; i < cacheCount && i < FORSYTH_CACHE_SIZE; i++ ){
+      int vertex = cache[i];
+      int begin = adjacencyOffset[vertex];
+      for( int j = begin; j < begin + valence[vertex]; j++ ){
+        int triangle = adjacency[j];
+        if( triangleScore[triangle] > bestScore ){
+          bestScore = triangleScore[triangle];
+          bestTriangle = triangle;
+        }
+      }
+    }
+    if( cacheCount > FORSYTH_CACHE_SIZE )
+      cacheCount = FORSYTH_CACHE_SIZE;
+  }
+  for( int i = 0; i < indexCount; i++ )
+    indices[i] = output[i];
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsVertexCacheStats analyzeMeshVertexCache( const ChsMeshSharedPtr & mesh ){
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  ChsVertexCacheStats stats = { 0.0f, 0.0f };
+  int misses = 0, referencedCount = 0, triangleCount = 0;
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    if( submesh.indexCount < 3 )
+      continue;
+    simulateVertexCache( &indices[submesh.firstIndex], submesh.indexCount, submesh.vertexCount,
+                         CHS_VERTEX_CACHE_SIZE, misses, referencedCount );
+    triangleCount += submesh.indexCount / 3;
+  }
+  if( triangleCount > 0 ){
+    stats.acmr = (float)misses / triangleCount;
+    stats.atvr = (float)misses / referencedCount;
+  }
+  return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+void optimizeMeshVertexCache( ChsMeshSharedPtr & mesh ){
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    if( submesh.indexCount < 3 )
+      continue;
+    optimizeVertexCache( &indices[submesh.firstIndex], submesh.indexCount, submesh.vertexCount );
+  }
+  mesh->setIndexArray( indices );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	remap[old vertex] receives the new position or -1 when the vertex is never used,
+//	indices are rewritten in place and the count of used vertices is returned
+//--------------------------------------------------------------------------------------------------
+int optimizeVertexFetchRemap( unsigned int * indices, int indexCount, int vertexCount, std::vector<int> & remap ){
+  remap.assign( vertexCount, -1 );
+  int nextVertex = 0;
+  for( int i = 0; i < indexCount; i++ ){
+    unsigned int vertex = indices[i];
+    if( remap[vertex] < 0 )
+      remap[vertex] = nextVertex++;
+    indices[i] = remap[vertex];
+  }
+  return nextVertex;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	submeshes addressing the same vertex range are remapped together, in submesh order
+//--------------------------------------------------------------------------------------------------
+void optimizeMeshVertexFetch( ChsMeshSharedPtr & mesh ){
+  int stride = mesh->vertexStride();
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  std::vector<float> newVertexArray;
+  newVertexArray.reserve( mesh->vertexArray.size() );
+  int submeshCount = mesh->submeshes.size();
+  std::vector<bool> isDone( submeshCount, false );
+  std::vector<int> remap;
+  std::vector<unsigned int> rangeIndices;
+  for( int i = 0; i < submeshCount; i++ ){
+    if( isDone[i] )
+      continue;
+    const ChsSubmesh range = mesh->submeshes[i];
+    rangeIndices.clear();
+    for( int j = i; j < submeshCount; j++ ){
+      const ChsSubmesh & submesh = mesh->submeshes[j];
+      if( !isDone[j] && submesh.firstVertex == range.firstVertex && submesh.vertexCount == range.vertexCount ){
+        rangeIndices.insert( rangeIndices.end(), indices.begin() + submesh.firstIndex,
+                             indices.begin() + submesh.firstIndex + submesh.indexCount );
+      }
+    }
+    int usedCount = optimizeVertexFetchRemap( rangeIndices.data(), rangeIndices.size(), range.vertexCount, remap );
+    int newFirstVertex = newVertexArray.size() / stride;
+    newVertexArray.resize( newVertexArray.size() + usedCount * stride );
+    for( int vertex = 0; vertex < range.vertexCount; vertex++ ){
+      if( remap[vertex] < 0 )
+        continue;
+      const float * source = &mesh->vertexArray[( range.firstVertex + vertex ) * stride];
+      std::copy( source, source + stride, newVertexArray.begin() + ( newFirstVertex + remap[vertex] ) * stride );
+    }
+    int rangeIndex = 0;
+    for( int j = i; j < submeshCount; j++ ){
+      ChsSubmesh & submesh = mesh->submeshes[j];
+      if( !isDone[j] && submesh.firstVertex == range.firstVertex && submesh.vertexCount == range.vertexCount ){
+        std::copy( rangeIndices.begin() + rangeIndex, rangeIndices.begin() + rangeIndex + submesh.indexCount,
+                   indices.begin() + submesh.firstIndex );
+        rangeIndex += submesh.indexCount;
+        submesh.firstVertex = newFirstVertex;
+        submesh.vertexCount = usedCount;
+        isDone[j] = true;
+      }
+    }
+  }
+  mesh->vertexArray.swap( newVertexArray );
+  mesh->setIndexArray( indices );
+}
+
+//--------------------------------------------------------------------------------------------------
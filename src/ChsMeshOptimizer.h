@@ -0,0 +1,33 @@
+#ifndef _CHSMESHOPTIMIZER_H
+#define _CHSMESHOPTIMIZER_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Post transform cache figures from a FIFO cache simulation.
+//	acmr: transformed vertices per triangle, atvr: transformed vertices per referenced vertex.
+//--------------------------------------------------------------------------------------------------
+struct ChsVertexCacheStats{
+  float acmr;
+  float atvr;
+};
+
+enum{
+  CHS_VERTEX_CACHE_SIZE = 16,
+};
+
+//--------------------------------------------------------------------------------------------------
+ChsVertexCacheStats analyzeVertexCache( const unsigned int * indices, int indexCount, int vertexCount,
+                                        int cacheSize = CHS_VERTEX_CACHE_SIZE );
+void optimizeVertexCache( unsigned int * indices, int indexCount, int vertexCount );
+int optimizeVertexFetchRemap( unsigned int * indices, int indexCount, int vertexCount, std::vector<int> & remap );
+
+//--------------------------------------------------------------------------------------------------
+ChsVertexCacheStats analyzeMeshVertexCache( const ChsMeshSharedPtr & mesh );
+void optimizeMeshVertexCache( ChsMeshSharedPtr & mesh );
+//reorders vertexArray by first use in the final index order, run after any triangle reordering
+void optimizeMeshVertexFetch( ChsMeshSharedPtr & mesh );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHOPTIMIZER_H
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <string.h>
+
+#include "ChsMeshPipeline.h"
+#include "ChsMeshSplitter.h"
+#include "ChsMeshletBuilder.h"
+#include "ChsMeshSimplifier.h"
+#include "ChsVertexEncoder.h"
+#include "ChsDepthMesh.h"
+#include "ChsTangentGenerator.h"
+#include "ChsIndexCodec.h"
+#include "ChsVertexCodec.h"
+#include "ChsGeometryCodec.h"
+
+//--------------------------------------------------------------------------------------------------
+//	every level simplifies the full detail submeshes, so errors do not pile up along the chain
+//--------------------------------------------------------------------------------------------------
+void buildLods( ChsMeshSharedPtr & mesh, const ChsExportOptions & options ){
+  mesh->lods.clear();
+  int stride = mesh->vertexStride();
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  std::vector<unsigned int> simplified;
+  for( size_t level = 0; level < options.lodRatios.size(); level++ ){
+    ChsLod lod;
+    lod.ratio = options.lodRatios[level];
+    lod.error = 0.0f;
+    for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+      const ChsSubmesh & submesh = mesh->submeshes[i];
+      int targetIndexCount = (int)( submesh.indexCount / 3 * lod.ratio ) * 3;
+      float error = simplifyMesh( simplified, &indices[submesh.firstIndex], submesh.indexCount,
+                                  &mesh->vertexArray[submesh.firstVertex * stride], submesh.vertexCount, stride,
+                                  targetIndexCount, options.lodError );
+      optimizeVertexCache( simplified.data(), simplified.size(), submesh.vertexCount );
+      ChsSubmesh range = submesh;
+      range.firstIndex = lod.indices.size();
+      range.indexCount = simplified.size();
+      lod.submeshes.push_back( range );
+      lod.indices.insert( lod.indices.end(), simplified.begin(), simplified.end() );
+      lod.error = std::max( lod.error, error );
+    }
+    mesh->lods.push_back( lod );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	every submesh is a stream of its own, its indices start over from 0
+//--------------------------------------------------------------------------------------------------
+void encodeIndexRanges( const std::vector<unsigned int> & indices, const std::vector<ChsSubmesh> & submeshes,
+                        std::vector<unsigned char> & encoded ){
+  encoded.clear();
+  std::vector<unsigned char> stream;
+  for( size_t i = 0; i < submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = submeshes[i];
+    stream.resize( encodeIndexBufferBound( submesh.indexCount ) );
+    unsigned int size = encodeIndexBuffer( stream.data(), stream.size(), indices.data() + submesh.firstIndex,
+                                           submesh.indexCount );
+    const unsigned char * sizeBytes = reinterpret_cast<const unsigned char *>( &size );
+    encoded.insert( encoded.end(), sizeBytes, sizeBytes + sizeof( size ) );
+    encoded.insert( encoded.end(), stream.begin(), stream.begin() + size );
+    encoded.resize( ( encoded.size() + 3 ) & ~3, 0 );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the vertex buffer is in first use order by now, which the codec deltas rely on
+//--------------------------------------------------------------------------------------------------
+void encodeVertexStreams( ChsMeshSharedPtr & mesh ){
+  mesh->encodedVertexData.clear();
+  int vertexCount = mesh->vertexCount();
+  std::vector<unsigned char> widths;
+  std::vector<unsigned char> stream;
+  for( size_t i = 0; i < mesh->streams.size(); i++ ){
+    makeVertexChannels( *mesh, i, widths );
+    stream.resize( encodeVertexBufferBound( vertexCount, widths.size() ) );
+    unsigned int size = encodeVertexBuffer( stream.data(), stream.size(), &mesh->vertexData[mesh->streams[i].offset],
+                                            vertexCount, widths.data(), widths.size() );
+    const unsigned char * sizeBytes = reinterpret_cast<const unsigned char *>( &size );
+    mesh->encodedVertexData.insert( mesh->encodedVertexData.end(), sizeBytes, sizeBytes + sizeof( size ) );
+    mesh->encodedVertexData.insert( mesh->encodedVertexData.end(), stream.begin(), stream.begin() + size );
+    mesh->encodedVertexData.resize( ( mesh->encodedVertexData.size() + 3 ) & ~3, 0 );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	triangles of every submesh in geometry codec traversal order, vertex fetch order follows
+//--------------------------------------------------------------------------------------------------
+void orderMeshForGeometryCodec( ChsMeshSharedPtr & mesh ){
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    orderGeometryTriangles( &indices[submesh.firstIndex], &submesh.indexCount, 1 );
+  }
+  mesh->setIndexArray( indices );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	one stream per vertex range like the fetch optimizer made them, empty when one fails
+//--------------------------------------------------------------------------------------------------
+void encodeGeometryRanges( ChsMeshSharedPtr & mesh, const ChsExportOptions & options ){
+  mesh->encodedGeometry.clear();
+  int stride = mesh->vertexStride();
+  std::vector<ChsGeometryAttribute> attributes;
+  ChsGeometryAttribute position = { CHS_GEOMETRY_LINEAR, 3, options.positionBits, 0 };
+  attributes.push_back( position );
+  ChsGeometryAttribute normal = { CHS_GEOMETRY_NORMAL, 3, 10, 3 };
+  attributes.push_back( normal );
+  int offset = 6;
+  if( mesh->hasUV && mesh->hasTexture ){
+    ChsGeometryAttribute texcoord = { CHS_GEOMETRY_LINEAR, 2, options.texcoordBits, offset };
+    attributes.push_back( texcoord );
+    offset += 2;
+  }
+  if( mesh->hasVertexColor ){
+    ChsGeometryAttribute color = { CHS_GEOMETRY_LINEAR, 4, 8, offset };
+    attributes.push_back( color );
+    offset += 4;
+  }
+  if( mesh->hasTangent ){
+    ChsGeometryAttribute tangent = { CHS_GEOMETRY_TANGENT, 4, 10, offset };
+    attributes.push_back( tangent );
+  }
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  int submeshCount = mesh->submeshes.size();
+  std::vector<bool> isDone( submeshCount, false );
+  std::vector<unsigned int> rangeIndices;
+  std::vector<int> indexCounts;
+  std::vector<unsigned char> stream;
+  for( int i = 0; i < submeshCount; i++ ){
+    if( isDone[i] )
+      continue;
+    const ChsSubmesh & range = mesh->submeshes[i];
+    rangeIndices.clear();
+    indexCounts.clear();
+    for( int j = i; j < submeshCount; j++ ){
+      const ChsSubmesh & submesh = mesh->submeshes[j];
+      if( !isDone[j] && submesh.firstVertex == range.firstVertex && submesh.vertexCount == range.vertexCount ){
+        rangeIndices.insert( rangeIndices.end(), indices.begin() + submesh.firstIndex,
+                             indices.begin() + submesh.firstIndex + submesh.indexCount );
+        indexCounts.push_back( submesh.indexCount );
+        isDone[j] = true;
+      }
+    }
+    if( !encodeGeometry( stream, &mesh->vertexArray[range.firstVertex * stride], range.vertexCount, stride,
+                         attributes.data(), attributes.size(), rangeIndices.data(), indexCounts.data(),
+                         indexCounts.size() ) ){
+      mesh->encodedGeometry.clear();
+      return;
+    }
+    unsigned int size = stream.size();
+    const unsigned char * sizeBytes = reinterpret_cast<const unsigned char *>( &size );
+    mesh->encodedGeometry.insert( mesh->encodedGeometry.end(), sizeBytes, sizeBytes + sizeof( size ) );
+    mesh->encodedGeometry.insert( mesh->encodedGeometry.end(), stream.begin(), stream.end() );
+    mesh->encodedGeometry.resize( ( mesh->encodedGeometry.size() + 3 ) & ~3, 0 );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	positions as a loader gets them from the geometry codec streams, false when one does not decode
+//--------------------------------------------------------------------------------------------------
+bool decodeGeometryPositions( const ChsMesh & mesh, std::vector<float> & positions ){
+  int stride = mesh.vertexStride();
+  positions.resize( mesh.vertexCount() * 3 );
+  int submeshCount = mesh.submeshes.size();
+  std::vector<bool> isDone( submeshCount, false );
+  std::vector<float> vertices;
+  std::vector<unsigned int> indices;
+  size_t position = 0;
+  for( int i = 0; i < submeshCount; i++ ){
+    if( isDone[i] )
+      continue;
+    const ChsSubmesh & range = mesh.submeshes[i];
+    int indexCount = 0;
+    for( int j = i; j < submeshCount; j++ ){
+      const ChsSubmesh & submesh = mesh.submeshes[j];
+      if( !isDone[j] && submesh.firstVertex == range.firstVertex && submesh.vertexCount == range.vertexCount ){
+        indexCount += submesh.indexCount;
+        isDone[j] = true;
+      }
+    }
+    unsigned int size;
+    if( mesh.encodedGeometry.size() - position < sizeof( size ) )
+      return false;
+    memcpy( &size, &mesh.encodedGeometry[position], sizeof( size ) );
+    position += sizeof( size );
+    if( mesh.encodedGeometry.size() - position < size )
+      return false;
+    vertices.resize( (size_t)range.vertexCount * stride );
+    indices.resize( indexCount );
+    if( decodeGeometry( vertices.data(), range.vertexCount, stride, indices.data(), indexCount,
+                        &mesh.encodedGeometry[position], size ) != 0 )
+      return false;
+    for( int k = 0; k < range.vertexCount; k++ )
+      memcpy( &positions[( range.firstVertex + k ) * 3], &vertices[(size_t)k * stride], 3 * sizeof( float ) );
+    position = std::min( position + ( ( size + 3 ) & ~3u ), mesh.encodedGeometry.size() );
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	from the positions the main stream stores, after its quantization, so a depth prepass and an
+//	EQUAL color pass agree
+//--------------------------------------------------------------------------------------------------
+void buildStreamDepthMesh( ChsMeshSharedPtr & mesh ){
+  if( mesh->vertexCount() == 0 )
+    return;
+  if( !mesh->encodedGeometry.empty() ){
+    std::vector<float> positions;
+    if( decodeGeometryPositions( *mesh, positions ) ){
+      buildDepthMesh( mesh, reinterpret_cast<const unsigned char *>( positions.data() ), 3 * sizeof( float ),
+                      3 * sizeof( float ) );
+    }
+    return;
+  }
+  //positions always open the first stream
+  const ChsVertexAttribute & position = mesh->attributes[0];
+  const ChsVertexStream & stream = mesh->streams[position.stream];
+  buildDepthMesh( mesh, &mesh->vertexData[stream.offset + position.offset], stream.stride,
+                  position.components * vertexAttributeTypeSize( position.type ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	after a pass, with the bytes of copies the pipeline itself still holds
+//--------------------------------------------------------------------------------------------------
+static void samplePeakBytes( const ChsMesh & mesh, size_t scratchBytes, ChsMeshReport & report ){
+  report.peakBytes = std::max( report.peakBytes, mesh.memorySize() + scratchBytes );
+}
+
+//--------------------------------------------------------------------------------------------------
+void runMeshPipeline( ChsMeshSharedPtr & mesh, const ChsExportOptions & options, ChsMeshReport & report ){
+  report.isSplit = false;
+  report.hasOverdraw = false;
+  report.peakBytes = 0;
+  //static batches already have the tangents of their sources
+  if( options.buildTangents ){
+    generateTangents( mesh );
+  }
+  //batches come cache optimized per source mesh, reordering would mix up their batch ranges
+  bool keepTriangleOrder = !mesh->batchRanges.empty();
+  //the geometry codec walks triangles in an order of its own, the cache passes would be undone
+  bool useGeometryCodec = options.compressGeometry && !keepTriangleOrder;
+  samplePeakBytes( *mesh, 0, report );
+  if( options.splitMeshes && !mesh->isShort && !keepTriangleOrder ){
+    splitMesh( mesh );
+    report.isSplit = true;
+    samplePeakBytes( *mesh, 0, report );
+  }
+  report.cacheBefore = analyzeMeshVertexCache( mesh );
+  if( !keepTriangleOrder && !useGeometryCodec ){
+    optimizeMeshVertexCache( mesh );
+  }
+  if( options.overdrawThreshold > 0.0f && !keepTriangleOrder && !useGeometryCodec ){
+    report.hasOverdraw = true;
+    report.overdrawBefore = analyzeMeshOverdraw( mesh );
+    optimizeMeshOverdraw( mesh, options.overdrawThreshold );
+    report.overdrawAfter = analyzeMeshOverdraw( mesh );
+  }
+  if( useGeometryCodec ){
+    orderMeshForGeometryCodec( mesh );
+  }
+  optimizeMeshVertexFetch( mesh );
+  if( options.buildMeshlets ){
+    buildMeshlets( mesh, options.meshletVertices, options.meshletTriangles );
+    samplePeakBytes( *mesh, 0, report );
+  }
+  report.cacheAfter = analyzeMeshVertexCache( mesh );
+  if( !options.lodRatios.empty() ){
+    buildLods( mesh, options );
+    samplePeakBytes( *mesh, 0, report );
+  }
+  //geometry codec streams decode to the plain float layout
+  encodeMeshVertices( mesh, options.quantizeVertices && !useGeometryCodec, options.normalBits,
+                      options.splitStreams && !useGeometryCodec );
+  samplePeakBytes( *mesh, 0, report );
+  //the codec passes each hold a copy of the index list
+  size_t indexCopyBytes = (size_t)mesh->indexCount() * sizeof( unsigned int );
+  if( useGeometryCodec ){
+    encodeGeometryRanges( mesh, options );
+    samplePeakBytes( *mesh, 2 * indexCopyBytes, report );
+  }
+  if( options.buildDepthMesh ){
+    buildStreamDepthMesh( mesh );
+    samplePeakBytes( *mesh, 0, report );
+  }
+  if( options.encodeVertices && mesh->encodedGeometry.empty() && mesh->vertexCount() > 0 ){
+    encodeVertexStreams( mesh );
+    samplePeakBytes( *mesh, 0, report );
+  }
+  if( options.encodeIndices ){
+    std::vector<unsigned int> indices;
+    mesh->getIndexArray( indices );
+    if( mesh->encodedGeometry.empty() )
+      encodeIndexRanges( indices, mesh->submeshes, mesh->encodedIndexArray );
+    for( size_t level = 0; level < mesh->lods.size(); level++ ){
+      ChsLod & lod = mesh->lods[level];
+      encodeIndexRanges( lod.indices, lod.submeshes, lod.encodedIndices );
+    }
+    samplePeakBytes( *mesh, indexCopyBytes, report );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,29 @@
+#ifndef _CHSMESHPIPELINE_H
+#define _CHSMESHPIPELINE_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+#include "ChsExportOptions.h"
+#include "ChsMeshOptimizer.h"
+#include "ChsOverdrawOptimizer.h"
+
+//--------------------------------------------------------------------------------------------------
+//	What the pipeline did to one mesh, logged by the caller on the main thread
+//--------------------------------------------------------------------------------------------------
+struct ChsMeshReport{
+  bool isSplit;
+  ChsVertexCacheStats cacheBefore;
+  ChsVertexCacheStats cacheAfter;
+  bool hasOverdraw;
+  ChsOverdrawStats overdrawBefore;
+  ChsOverdrawStats overdrawAfter;
+  size_t peakBytes;         //mesh buffers plus the pipeline's index copies, largest between passes
+};
+
+//--------------------------------------------------------------------------------------------------
+//	All Maya independent passes over a built mesh, safe to run for several meshes at once
+//--------------------------------------------------------------------------------------------------
+void runMeshPipeline( ChsMeshSharedPtr & mesh, const ChsExportOptions & options, ChsMeshReport & report );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHPIPELINE_H
@@ -0,0 +1,467 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+#include "ChsMeshSimplifier.h"
+#include "ChsVertexWelder.h"
+
+//--------------------------------------------------------------------------------------------------
+struct Quadric{
+  double a00, a11, a22, a01, a02, a12;
+  double b0, b1, b2;
+  double c;
+  double weight;
+};
+
+//--------------------------------------------------------------------------------------------------
+static void addPlaneQuadric( Quadric & q, const double * n, double d, double weight ){
+  q.a00 += n[0] * n[0] * weight;
+  q.a11 += n[1] * n[1] * weight;
+  q.a22 += n[2] * n[2] * weight;
+  q.a01 += n[0] * n[1] * weight;
+  q.a02 += n[0] * n[2] * weight;
+  q.a12 += n[1] * n[2] * weight;
+  q.b0 += n[0] * d * weight;
+  q.b1 += n[1] * d * weight;
+  q.b2 += n[2] * d * weight;
+  q.c += d * d * weight;
+  q.weight += weight;
+}
+
+//--------------------------------------------------------------------------------------------------
+static void addQuadric( Quadric & q, const Quadric & other ){
+  q.a00 += other.a00;
+  q.a11 += other.a11;
+  q.a22 += other.a22;
+  q.a01 += other.a01;
+  q.a02 += other.a02;
+  q.a12 += other.a12;
+  q.b0 += other.b0;
+  q.b1 += other.b1;
+  q.b2 += other.b2;
+  q.c += other.c;
+  q.weight += other.weight;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	mean squared distance from the planes gathered in q
+//--------------------------------------------------------------------------------------------------
+static double evaluateQuadric( const Quadric & q, const double * p ){
+  if( q.weight <= 0.0 )
+    return 0.0;
+  double r = q.a00 * p[0] * p[0] + q.a11 * p[1] * p[1] + q.a22 * p[2] * p[2] +
+             2.0 * ( q.a01 * p[0] * p[1] + q.a02 * p[0] * p[2] + q.a12 * p[1] * p[2] ) +
+             2.0 * ( q.b0 * p[0] + q.b1 * p[1] + q.b2 * p[2] ) + q.c;
+  return fabs( r ) / q.weight;
+}
+
+//--------------------------------------------------------------------------------------------------
+static void triangleNormal( const double * a, const double * b, const double * c, double * n ){
+  double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+  double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+//--------------------------------------------------------------------------------------------------
+struct PositionKey{
+  int x, y, z;
+};
+
+struct HalfEdge{
+  int from, to;
+};
+
+enum VertexKind{
+  KIND_MANIFOLD,
+  KIND_BORDER,
+  KIND_SEAM,
+  KIND_LOCKED,
+};
+
+struct Collapse{
+  int from, to;
+  double cost;
+  bool operator < ( const Collapse & other )const{
+    return cost < other.cost;
+  }
+};
+
+enum{
+  MAX_WEDGES = 8,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Working state, vertices are wedges (full attribute vertices) and remap holds the first wedge
+//	of every position, which stands for the position itself
+//--------------------------------------------------------------------------------------------------
+class Simplifier {
+public:
+  Simplifier( const float * vertices, int vertexCount, int vertexStride, float attributeWeight );
+  void initQuadrics( const std::vector<unsigned int> & indices );
+  bool collapsePass( std::vector<unsigned int> & indices, int targetTriangleCount, double maxCost,
+                     double & reachedCost );
+
+private:
+  const float * vertices;
+  int vertexCount;
+  int vertexStride;
+  float attributeWeight;
+  std::vector<int> remap;
+  std::vector<double> positions;
+  std::vector<Quadric> quadrics;
+  std::vector<unsigned char> kinds;
+  std::vector<int> adjacencyOffset;
+  std::vector<int> adjacency;
+  ChsVertexWelder< HalfEdge > positionEdges;
+  ChsVertexWelder< HalfEdge > wedgeEdges;
+
+  void buildAdjacency( const std::vector<unsigned int> & indices );
+  void classifyVertices( const std::vector<unsigned int> & indices );
+  bool isOpenEdge( int from, int to )const;
+  bool isSeamEdge( int wedgeFrom, int wedgeTo )const;
+  bool mapWedges( const std::vector<unsigned int> & indices, int from, int to,
+                  int * wedgeFrom, int * wedgeTo, int & wedgeCount )const;
+  bool flipsTriangles( const std::vector<unsigned int> & indices, int from, int to )const;
+  double attributeCost( const int * wedgeFrom, const int * wedgeTo, int wedgeCount )const;
+};
+
+//--------------------------------------------------------------------------------------------------
+Simplifier::Simplifier( const float * vertices, int vertexCount, int vertexStride, float attributeWeight ) :
+  vertices( vertices ), vertexCount( vertexCount ), vertexStride( vertexStride ), attributeWeight( attributeWeight ){
+  //positions are normalized to the unit box so errors are relative to the mesh extent
+  float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    for( int axis = 0; axis < 3; axis++ ){
+      boundsMin[axis] = std::min( boundsMin[axis], vertices[vertex * vertexStride + axis] );
+      boundsMax[axis] = std::max( boundsMax[axis], vertices[vertex * vertexStride + axis] );
+    }
+  }
+  float extent = std::max( boundsMax[0] - boundsMin[0], std::max( boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2] ) );
+  double scale = extent > 0.0f ? 1.0 / extent : 0.0;
+  positions.resize( vertexCount * 3 );
+  remap.resize( vertexCount );
+  ChsVertexWelder< PositionKey > positionWelder;
+  positionWelder.reset( vertexCount );
+  std::vector<int> firstWedge;
+  firstWedge.reserve( vertexCount );
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    const float * pos = vertices + vertex * vertexStride;
+    PositionKey key;
+    memcpy( &key, pos, sizeof( key ) );
+    int position = positionWelder.weld( key );
+    if( position == (int)firstWedge.size() )
+      firstWedge.push_back( vertex );
+    remap[vertex] = firstWedge[position];
+    for( int axis = 0; axis < 3; axis++ )
+      positions[vertex * 3 + axis] = ( pos[axis] - boundsMin[axis] ) * scale;
+  }
+  Quadric zero;
+  memset( &zero, 0, sizeof( zero ) );
+  quadrics.assign( vertexCount, zero );
+  kinds.assign( vertexCount, KIND_LOCKED );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	plane quadrics weighted by area, plus planes standing on open edges to hold the borders
+//--------------------------------------------------------------------------------------------------
+void Simplifier::initQuadrics( const std::vector<unsigned int> & indices ){
+  buildAdjacency( indices );
+  int indexCount = indices.size();
+  for( int i = 0; i < indexCount; i += 3 ){
+    int corners[3] = { remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]] };
+    double n[3];
+    triangleNormal( &positions[corners[0] * 3], &positions[corners[1] * 3], &positions[corners[2] * 3], n );
+    double length = sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    if( length == 0.0 )
+      continue;
+    for( int axis = 0; axis < 3; axis++ )
+      n[axis] /= length;
+    const double * p0 = &positions[corners[0] * 3];
+    double d = -( n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2] );
+    for( int k = 0; k < 3; k++ )
+      addPlaneQuadric( quadrics[corners[k]], n, d, length * 0.5 );
+    for( int k = 0; k < 3; k++ ){
+      int from = corners[k], to = corners[( k + 1 ) % 3];
+      if( !isOpenEdge( from, to ) )
+        continue;
+      const double * a = &positions[from * 3];
+      const double * b = &positions[to * 3];
+      double edge[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+      double m[3] = { edge[1] * n[2] - edge[2] * n[1], edge[2] * n[0] - edge[0] * n[2], edge[0] * n[1] - edge[1] * n[0] };
+      double edgeLength = sqrt( m[0] * m[0] + m[1] * m[1] + m[2] * m[2] );
+      if( edgeLength == 0.0 )
+        continue;
+      for( int axis = 0; axis < 3; axis++ )
+        m[axis] /= edgeLength;
+      double md = -( m[0] * a[0] + m[1] * a[1] + m[2] * a[2] );
+      addPlaneQuadric( quadrics[from], m, md, edgeLength * edgeLength * 10.0 );
+      addPlaneQuadric( quadrics[to], m, md, edgeLength * edgeLength * 10.0 );
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void Simplifier::buildAdjacency( const std::vector<unsigned int> & indices ){
+  int indexCount = indices.size();
+  adjacencyOffset.assign( vertexCount + 1, 0 );
+  for( int i = 0; i < indexCount; i++ )
+    adjacencyOffset[remap[indices[i]] + 1]++;
+  for( int vertex = 0; vertex < vertexCount; vertex++ )
+    adjacencyOffset[vertex + 1] += adjacencyOffset[vertex];
+  adjacency.resize( indexCount );
+  std::vector<int> fill( adjacencyOffset.begin(), adjacencyOffset.end() - 1 );
+  for( int i = 0; i < indexCount; i++ )
+    adjacency[fill[remap[indices[i]]]++] = i / 3;
+  positionEdges.reset( indexCount );
+  wedgeEdges.reset( indexCount );
+  for( int i = 0; i < indexCount; i += 3 ){
+    for( int k = 0; k < 3; k++ ){
+      int from = indices[i + k], to = indices[i + ( k + 1 ) % 3];
+      HalfEdge positionEdge = { remap[from], remap[to] };
+      HalfEdge wedgeEdge = { from, to };
+      positionEdges.weld( positionEdge );
+      wedgeEdges.weld( wedgeEdge );
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+bool Simplifier::isOpenEdge( int from, int to )const{
+  HalfEdge opposite = { to, from };
+  return positionEdges.find( opposite ) < 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool Simplifier::isSeamEdge( int wedgeFrom, int wedgeTo )const{
+  HalfEdge opposite = { wedgeTo, wedgeFrom };
+  return !isOpenEdge( remap[wedgeFrom], remap[wedgeTo] ) && wedgeEdges.find( opposite ) < 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	manifold: no open or seam edge and one wedge; border: one open edge in and out, one wedge;
+//	seam: two wedges with two seam edges in and out; anything else stays where it is
+//--------------------------------------------------------------------------------------------------
+void Simplifier::classifyVertices( const std::vector<unsigned int> & indices ){
+  std::vector<int> openCount( vertexCount, 0 ), seamCount( vertexCount, 0 ), wedgeCount( vertexCount, 0 );
+  std::vector<bool> wedgeSeen( vertexCount, false );
+  int indexCount = indices.size();
+  for( int i = 0; i < indexCount; i += 3 ){
+    for( int k = 0; k < 3; k++ ){
+      int from = indices[i + k], to = indices[i + ( k + 1 ) % 3];
+      if( !wedgeSeen[from] ){
+        wedgeSeen[from] = true;
+        wedgeCount[remap[from]]++;
+      }
+      if( isOpenEdge( remap[from], remap[to] ) ){
+        openCount[remap[from]]++;
+        openCount[remap[to]]++;
+      }
+      else if( isSeamEdge( from, to ) ){
+        seamCount[remap[from]]++;
+        seamCount[remap[to]]++;
+      }
+    }
+  }
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    if( remap[vertex] != vertex || !wedgeCount[vertex] )
+      kinds[vertex] = KIND_LOCKED;
+    else if( wedgeCount[vertex] == 1 && !openCount[vertex] && !seamCount[vertex] )
+      kinds[vertex] = KIND_MANIFOLD;
+    else if( wedgeCount[vertex] == 1 && openCount[vertex] == 2 && !seamCount[vertex] )
+      kinds[vertex] = KIND_BORDER;
+    else if( wedgeCount[vertex] == 2 && !openCount[vertex] && seamCount[vertex] == 4 )
+      kinds[vertex] = KIND_SEAM;
+    else
+      kinds[vertex] = KIND_LOCKED;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	pairs every wedge of from with the wedge of to it shares a triangle with, fails when a wedge has
+//	no partner or two different ones
+//--------------------------------------------------------------------------------------------------
+bool Simplifier::mapWedges( const std::vector<unsigned int> & indices, int from, int to,
+                            int * wedgeFrom, int * wedgeTo, int & wedgeCount )const{
+  wedgeCount = 0;
+  int usedCount = 0;
+  int used[MAX_WEDGES];
+  for( int j = adjacencyOffset[from]; j < adjacencyOffset[from + 1]; j++ ){
+    const unsigned int * triangle = &indices[adjacency[j] * 3];
+    int cornerFrom = -1, cornerTo = -1;
+    for( int k = 0; k < 3; k++ ){
+      if( remap[triangle[k]] == from )
+        cornerFrom = triangle[k];
+      else if( remap[triangle[k]] == to )
+        cornerTo = triangle[k];
+    }
+    if( cornerFrom < 0 )
+      continue;
+    int u = 0;
+    while( u < usedCount && used[u] != cornerFrom )
+      u++;
+    if( u == usedCount ){
+      if( usedCount == MAX_WEDGES )
+        return false;
+      used[usedCount++] = cornerFrom;
+    }
+    if( cornerTo < 0 )
+      continue;
+    int w = 0;
+    while( w < wedgeCount && wedgeFrom[w] != cornerFrom )
+      w++;
+    if( w == wedgeCount ){
+      wedgeFrom[wedgeCount] = cornerFrom;
+      wedgeTo[wedgeCount] = cornerTo;
+      wedgeCount++;
+    }
+    else if( wedgeTo[w] != cornerTo ){
+      return false;
+    }
+  }
+  return wedgeCount > 0 && wedgeCount == usedCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool Simplifier::flipsTriangles( const std::vector<unsigned int> & indices, int from, int to )const{
+  for( int j = adjacencyOffset[from]; j < adjacencyOffset[from + 1]; j++ ){
+    const unsigned int * triangle = &indices[adjacency[j] * 3];
+    int corners[3] = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+    if( corners[0] == to || corners[1] == to || corners[2] == to )
+      continue;
+    if( corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2] )
+      continue;
+    double before[3], after[3];
+    const double * p[3];
+    for( int k = 0; k < 3; k++ )
+      p[k] = &positions[corners[k] * 3];
+    triangleNormal( p[0], p[1], p[2], before );
+    for( int k = 0; k < 3; k++ ){
+      if( corners[k] == from )
+        p[k] = &positions[to * 3];
+    }
+    triangleNormal( p[0], p[1], p[2], after );
+    double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+    double lengths = sqrt( before[0] * before[0] + before[1] * before[1] + before[2] * before[2] ) *
+                     sqrt( after[0] * after[0] + after[1] * after[1] + after[2] * after[2] );
+    if( dot <= 1e-2 * lengths )
+      return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+double Simplifier::attributeCost( const int * wedgeFrom, const int * wedgeTo, int wedgeCount )const{
+  double cost = 0.0;
+  for( int w = 0; w < wedgeCount; w++ ){
+    const float * a = vertices + wedgeFrom[w] * vertexStride;
+    const float * b = vertices + wedgeTo[w] * vertexStride;
+    for( int k = 3; k < vertexStride; k++ )
+      cost += ( a[k] - b[k] ) * ( a[k] - b[k] );
+  }
+  return cost * attributeWeight;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	one round of independent collapses, cheapest first; false when nothing could collapse
+//--------------------------------------------------------------------------------------------------
+bool Simplifier::collapsePass( std::vector<unsigned int> & indices, int targetTriangleCount, double maxCost,
+                               double & reachedCost ){
+  buildAdjacency( indices );
+  classifyVertices( indices );
+  int indexCount = indices.size();
+  int triangleCount = indexCount / 3;
+  std::vector<Collapse> collapses;
+  collapses.reserve( indexCount );
+  int wedgeFrom[MAX_WEDGES], wedgeTo[MAX_WEDGES], wedgeCount;
+  for( int i = 0; i < indexCount; i += 3 ){
+    for( int k = 0; k < 3; k++ ){
+      int a = indices[i + k], b = indices[i + ( k + 1 ) % 3];
+      int pa = remap[a], pb = remap[b];
+      bool isOpen = isOpenEdge( pa, pb );
+      if( pa == pb || ( pa > pb && !isOpen ) )
+        continue;
+      bool isSeam = !isOpen && isSeamEdge( a, b );
+      int ends[2] = { pa, pb };
+      for( int e = 0; e < 2; e++ ){
+        int from = ends[e], to = ends[1 - e];
+        int kind = kinds[from];
+        bool isAllowed = kind == KIND_MANIFOLD || ( kind == KIND_BORDER && isOpen ) || ( kind == KIND_SEAM && isSeam );
+        if( !isAllowed || !mapWedges( indices, from, to, wedgeFrom, wedgeTo, wedgeCount ) )
+          continue;
+        Collapse collapse = { from, to, evaluateQuadric( quadrics[from], &positions[to * 3] ) +
+                                        attributeCost( wedgeFrom, wedgeTo, wedgeCount ) };
+        collapses.push_back( collapse );
+      }
+    }
+  }
+  std::sort( collapses.begin(), collapses.end() );
+
+  std::vector<bool> isLocked( vertexCount, false );
+  std::vector<int> wedgeRemap( vertexCount );
+  for( int vertex = 0; vertex < vertexCount; vertex++ )
+    wedgeRemap[vertex] = vertex;
+  int removedCount = 0;
+  int collapseCount = 0;
+  for( size_t c = 0; c < collapses.size(); c++ ){
+    const Collapse & collapse = collapses[c];
+    if( collapse.cost > maxCost || triangleCount - removedCount <= targetTriangleCount )
+      break;
+    int from = collapse.from, to = collapse.to;
+    if( isLocked[from] || isLocked[to] )
+      continue;
+    if( !mapWedges( indices, from, to, wedgeFrom, wedgeTo, wedgeCount ) || flipsTriangles( indices, from, to ) )
+      continue;
+    for( int w = 0; w < wedgeCount; w++ )
+      wedgeRemap[wedgeFrom[w]] = wedgeTo[w];
+    addQuadric( quadrics[to], quadrics[from] );
+    //the one ring of the moved vertex waits for the next pass
+    for( int j = adjacencyOffset[from]; j < adjacencyOffset[from + 1]; j++ ){
+      const unsigned int * triangle = &indices[adjacency[j] * 3];
+      bool hasTo = false;
+      for( int k = 0; k < 3; k++ ){
+        isLocked[remap[triangle[k]]] = true;
+        hasTo |= remap[triangle[k]] == to;
+      }
+      removedCount += hasTo;
+    }
+    reachedCost = std::max( reachedCost, collapse.cost );
+    collapseCount++;
+  }
+  if( !collapseCount )
+    return false;
+  int writeIndex = 0;
+  for( int i = 0; i < indexCount; i += 3 ){
+    unsigned int a = wedgeRemap[indices[i]], b = wedgeRemap[indices[i + 1]], c = wedgeRemap[indices[i + 2]];
+    if( remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c] )
+      continue;
+    indices[writeIndex++] = a;
+    indices[writeIndex++] = b;
+    indices[writeIndex++] = c;
+  }
+  indices.resize( writeIndex );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+float simplifyMesh( std::vector<unsigned int> & destination, const unsigned int * indices, int indexCount,
+                    const float * vertices, int vertexCount, int vertexStride,
+                    int targetIndexCount, float targetError, float attributeWeight ){
+  destination.assign( indices, indices + indexCount );
+  if( indexCount <= targetIndexCount || vertexCount == 0 )
+    return 0.0f;
+  Simplifier simplifier( vertices, vertexCount, vertexStride, attributeWeight );
+  simplifier.initQuadrics( destination );
+  double maxCost = (double)targetError * targetError;
+  double reachedCost = 0.0;
+  while( (int)destination.size() > targetIndexCount ){
+    if( !simplifier.collapsePass( destination, targetIndexCount / 3, maxCost, reachedCost ) )
+      break;
+  }
+  return (float)sqrt( reachedCost );
+}
+
+//--------------------------------------------------------------------------------------------------
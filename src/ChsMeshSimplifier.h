@@ -0,0 +1,20 @@
+#ifndef _CHSMESHSIMPLIFIER_H
+#define _CHSMESHSIMPLIFIER_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//	Quadric edge collapse over an indexed triangle list.
+//	vertices are interleaved floats starting with the position; every float after the position is
+//	treated as an attribute and adds attributeWeight * difference^2 to the collapse cost.
+//	Vertices sharing a position (uv or normal seams) are collapsed together along seam edges only,
+//	open borders only collapse along the border. The result indexes the same vertices.
+//	targetError is relative to the mesh extent, the reached error is returned the same way.
+//--------------------------------------------------------------------------------------------------
+float simplifyMesh( std::vector<unsigned int> & destination, const unsigned int * indices, int indexCount,
+                    const float * vertices, int vertexCount, int vertexStride,
+                    int targetIndexCount, float targetError, float attributeWeight = 0.01f );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHSIMPLIFIER_H
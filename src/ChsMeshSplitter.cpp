@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <float.h>
+
+#include "ChsMeshSplitter.h"
+
+//--------------------------------------------------------------------------------------------------
+struct TriangleKey{
+  unsigned int code;
+  int triangle;
+  bool operator < ( const TriangleKey & other )const{
+    return code < other.code || ( code == other.code && triangle < other.triangle );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+static unsigned int spreadBits( unsigned int value ){
+  value &= 0x3ff;
+  value = ( value | ( value << 16 ) ) & 0x030000ff;
+  value = ( value | ( value << 8 ) ) & 0x0300f00f;
+  value = ( value | ( value << 4 ) ) & 0x030c30c3;
+  value = ( value | ( value << 2 ) ) & 0x09249249;
+  return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	orders the triangles of one range along a morton curve through their centroids
+//--------------------------------------------------------------------------------------------------
+void sortTrianglesSpatially( const ChsMesh & mesh, const ChsSubmesh & submesh,
+                             const std::vector<unsigned int> & indices, std::vector<TriangleKey> & keys ){
+  int stride = mesh.vertexStride();
+  int triangleCount = submesh.indexCount / 3;
+  std::vector<float> centroids( triangleCount * 3 );
+  float minPos[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float maxPos[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    float * centroid = &centroids[triangle * 3];
+    centroid[0] = centroid[1] = centroid[2] = 0.0f;
+    for( int k = 0; k < 3; k++ ){
+      int vertex = submesh.firstVertex + indices[submesh.firstIndex + triangle * 3 + k];
+      const float * pos = &mesh.vertexArray[vertex * stride];
+      for( int axis = 0; axis < 3; axis++ )
+        centroid[axis] += pos[axis] / 3.0f;
+    }
+    for( int axis = 0; axis < 3; axis++ ){
+      minPos[axis] = std::min( minPos[axis], centroid[axis] );
+      maxPos[axis] = std::max( maxPos[axis], centroid[axis] );
+    }
+  }
+  float scale[3];
+  for( int axis = 0; axis < 3; axis++ ){
+    float extent = maxPos[axis] - minPos[axis];
+    scale[axis] = extent > 0.0f ? 1023.0f / extent : 0.0f;
+  }
+  keys.resize( triangleCount );
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const float * centroid = &centroids[triangle * 3];
+    unsigned int code = 0;
+    for( int axis = 0; axis < 3; axis++ )
+      code |= spreadBits( (unsigned int)( ( centroid[axis] - minPos[axis] ) * scale[axis] ) ) << axis;
+    keys[triangle].code = code;
+    keys[triangle].triangle = triangle;
+  }
+  std::sort( keys.begin(), keys.end() );
+}
+
+//--------------------------------------------------------------------------------------------------
+void splitSubmesh( const ChsMesh & mesh, const ChsSubmesh & submesh, const std::vector<unsigned int> & indices,
+                   int maxVertexCount, std::vector<float> & newVertexArray,
+                   std::vector<unsigned int> & newIndices, std::vector<ChsSubmesh> & newSubmeshes ){
+  int stride = mesh.vertexStride();
+  std::vector<TriangleKey> keys;
+  sortTrianglesSpatially( mesh, submesh, indices, keys );
+  //remap holds the chunk local index of a source vertex, valid while stamp matches the chunk
+  std::vector<int> remap( submesh.vertexCount, -1 );
+  std::vector<int> stamp( submesh.vertexCount, -1 );
+  int chunk = -1;
+  ChsSubmesh current = { 0, 0, 0, 0, submesh.material };
+  int triangleCount = keys.size();
+  for( int i = 0; i < triangleCount; i++ ){
+    const unsigned int * triangle = &indices[submesh.firstIndex + keys[i].triangle * 3];
+    int newVertexCount = 0;
+    for( int k = 0; k < 3; k++ ){
+      if( stamp[triangle[k]] != chunk )
+        newVertexCount++;
+    }
+    if( chunk < 0 || current.vertexCount + newVertexCount > maxVertexCount ){
+      if( chunk >= 0 )
+        newSubmeshes.push_back( current );
+      chunk++;
+      current.firstVertex = newVertexArray.size() / stride;
+      current.vertexCount = 0;
+      current.firstIndex = newIndices.size();
+      current.indexCount = 0;
+    }
+    for( int k = 0; k < 3; k++ ){
+      unsigned int vertex = triangle[k];
+      if( stamp[vertex] != chunk ){
+        stamp[vertex] = chunk;
+        remap[vertex] = current.vertexCount++;
+        const float * source = &mesh.vertexArray[( submesh.firstVertex + vertex ) * stride];
+        newVertexArray.insert( newVertexArray.end(), source, source + stride );
+      }
+      newIndices.push_back( remap[vertex] );
+    }
+    current.indexCount += 3;
+  }
+  if( chunk >= 0 )
+    newSubmeshes.push_back( current );
+}
+
+//--------------------------------------------------------------------------------------------------
+void splitMesh( ChsMeshSharedPtr & mesh, int maxVertexCount ){
+  bool needSplit = false;
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ )
+    needSplit |= mesh->submeshes[i].vertexCount > maxVertexCount;
+  if( !needSplit )
+    return;
+  int stride = mesh->vertexStride();
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  std::vector<float> newVertexArray;
+  std::vector<unsigned int> newIndices;
+  std::vector<ChsSubmesh> newSubmeshes;
+  newVertexArray.reserve( mesh->vertexArray.size() + mesh->vertexArray.size() / 8 );
+  newIndices.reserve( indices.size() );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    if( submesh.vertexCount > maxVertexCount ){
+      splitSubmesh( *mesh, submesh, indices, maxVertexCount, newVertexArray, newIndices, newSubmeshes );
+      continue;
+    }
+    ChsSubmesh copied = submesh;
+    copied.firstVertex = newVertexArray.size() / stride;
+    copied.firstIndex = newIndices.size();
+    const float * source = &mesh->vertexArray[submesh.firstVertex * stride];
+    newVertexArray.insert( newVertexArray.end(), source, source + submesh.vertexCount * stride );
+    newIndices.insert( newIndices.end(), indices.begin() + submesh.firstIndex,
+                       indices.begin() + submesh.firstIndex + submesh.indexCount );
+    newSubmeshes.push_back( copied );
+  }
+  mesh->vertexArray.swap( newVertexArray );
+  mesh->submeshes.swap( newSubmeshes );
+  mesh->setIndexArray( newIndices );
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,16 @@
+#ifndef _CHSMESHSPLITTER_H
+#define _CHSMESHSPLITTER_H
+//--------------------------------------------------------------------------------------------------
+#include <limits.h>
+
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Cuts every submesh addressing more than maxVertexCount vertices into spatially coherent
+//	chunks that fit, so the whole mesh can keep 16 bit indices.
+//--------------------------------------------------------------------------------------------------
+void splitMesh( ChsMeshSharedPtr & mesh, int maxVertexCount = USHRT_MAX );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHSPLITTER_H
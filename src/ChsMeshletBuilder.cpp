@@ -0,0 +1,166 @@
+#include <math.h>
+#include <vector>
+
+#include "ChsMeshletBuilder.h"
+
+//--------------------------------------------------------------------------------------------------
+static inline float distanceSquared( const float * a, const float * b ){
+  float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Ritter's bounding sphere
+//--------------------------------------------------------------------------------------------------
+static void computeBoundingSphere( const ChsMesh & mesh, const unsigned int * vertices, int vertexCount,
+                                   ChsMeshlet & meshlet ){
+  int stride = mesh.vertexStride();
+  const float * positions = mesh.vertexArray.data();
+  const float * first = positions + vertices[0] * stride;
+  const float * a = first;
+  for( int i = 1; i < vertexCount; i++ ){
+    const float * pos = positions + vertices[i] * stride;
+    if( distanceSquared( pos, first ) > distanceSquared( a, first ) )
+      a = pos;
+  }
+  const float * b = a;
+  for( int i = 0; i < vertexCount; i++ ){
+    const float * pos = positions + vertices[i] * stride;
+    if( distanceSquared( pos, a ) > distanceSquared( b, a ) )
+      b = pos;
+  }
+  float center[3] = { ( a[0] + b[0] ) * 0.5f, ( a[1] + b[1] ) * 0.5f, ( a[2] + b[2] ) * 0.5f };
+  float radius = sqrtf( distanceSquared( a, b ) ) * 0.5f;
+  for( int i = 0; i < vertexCount; i++ ){
+    const float * pos = positions + vertices[i] * stride;
+    float distance = sqrtf( distanceSquared( pos, center ) );
+    if( distance > radius ){
+      float shift = ( distance - radius ) * 0.5f / distance;
+      for( int axis = 0; axis < 3; axis++ )
+        center[axis] += ( pos[axis] - center[axis] ) * shift;
+      radius = ( radius + distance ) * 0.5f;
+    }
+  }
+  for( int axis = 0; axis < 3; axis++ )
+    meshlet.center[axis] = center[axis];
+  meshlet.radius = radius;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	axis is the mean triangle normal, the cutoff is the sine of the widest normal angle around it
+//	and the apex sits behind the cluster so that every triangle plane is in front of it
+//--------------------------------------------------------------------------------------------------
+static void computeNormalCone( const ChsMesh & mesh, const unsigned int * vertices,
+                               const unsigned char * triangles, int triangleCount, ChsMeshlet & meshlet ){
+  int stride = mesh.vertexStride();
+  const float * positions = mesh.vertexArray.data();
+  std::vector<float> normals( triangleCount * 3 );
+  float axis[3] = { 0.0f, 0.0f, 0.0f };
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const float * a = positions + vertices[triangles[triangle * 3]] * stride;
+    const float * b = positions + vertices[triangles[triangle * 3 + 1]] * stride;
+    const float * c = positions + vertices[triangles[triangle * 3 + 2]] * stride;
+    float * n = &normals[triangle * 3];
+    n[0] = ( b[1] - a[1] ) * ( c[2] - a[2] ) - ( b[2] - a[2] ) * ( c[1] - a[1] );
+    n[1] = ( b[2] - a[2] ) * ( c[0] - a[0] ) - ( b[0] - a[0] ) * ( c[2] - a[2] );
+    n[2] = ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( b[1] - a[1] ) * ( c[0] - a[0] );
+    float length = sqrtf( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+    for( int k = 0; k < 3; k++ ){
+      n[k] *= invLength;
+      axis[k] += n[k];
+    }
+  }
+  float length = sqrtf( axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] );
+  float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+  for( int k = 0; k < 3; k++ ){
+    axis[k] *= invLength;
+    meshlet.coneAxis[k] = axis[k];
+    meshlet.coneApex[k] = meshlet.center[k];
+  }
+  meshlet.coneCutoff = 1.0f;
+  float minDot = 1.0f;
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const float * n = &normals[triangle * 3];
+    float dot = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+    if( dot < minDot )
+      minDot = dot;
+  }
+  //normals spread too wide for the cone to ever cull
+  if( length == 0.0f || minDot <= 0.1f )
+    return;
+  float maxT = 0.0f;
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const float * n = &normals[triangle * 3];
+    const float * a = positions + vertices[triangles[triangle * 3]] * stride;
+    float dc = ( meshlet.center[0] - a[0] ) * n[0] + ( meshlet.center[1] - a[1] ) * n[1] +
+               ( meshlet.center[2] - a[2] ) * n[2];
+    float dn = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+    float t = dc / dn;
+    if( t > maxT )
+      maxT = t;
+  }
+  for( int k = 0; k < 3; k++ )
+    meshlet.coneApex[k] = meshlet.center[k] - axis[k] * maxT;
+  meshlet.coneCutoff = sqrtf( 1.0f - minDot * minDot );
+}
+
+//--------------------------------------------------------------------------------------------------
+static void finishMeshlet( ChsMesh & mesh, ChsMeshlet & meshlet ){
+  if( !meshlet.triangleCount )
+    return;
+  const unsigned int * vertices = &mesh.meshletVertices[meshlet.vertexOffset];
+  const unsigned char * triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+  computeBoundingSphere( mesh, vertices, meshlet.vertexCount, meshlet );
+  computeNormalCone( mesh, vertices, triangles, meshlet.triangleCount, meshlet );
+  mesh.meshlets.push_back( meshlet );
+}
+
+//--------------------------------------------------------------------------------------------------
+void buildMeshlets( ChsMeshSharedPtr & mesh, int maxVertices, int maxTriangles ){
+  mesh->meshlets.clear();
+  mesh->meshletVertices.clear();
+  mesh->meshletTriangles.clear();
+  if( maxVertices > 255 )
+    maxVertices = 255;
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  std::vector<int> localIndex;
+  for( size_t submeshIndex = 0; submeshIndex < mesh->submeshes.size(); submeshIndex++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[submeshIndex];
+    localIndex.assign( submesh.vertexCount, -1 );
+    ChsMeshlet meshlet = ChsMeshlet();
+    meshlet.submesh = submeshIndex;
+    meshlet.vertexOffset = mesh->meshletVertices.size();
+    meshlet.triangleOffset = mesh->meshletTriangles.size();
+    for( int index = submesh.firstIndex; index + 2 < submesh.firstIndex + submesh.indexCount; index += 3 ){
+      const unsigned int * triangle = &indices[index];
+      int newVertexCount = ( localIndex[triangle[0]] < 0 ) + ( localIndex[triangle[1]] < 0 ) +
+                           ( localIndex[triangle[2]] < 0 );
+      if( (int)meshlet.vertexCount + newVertexCount > maxVertices || (int)meshlet.triangleCount + 1 > maxTriangles ){
+        for( unsigned int i = 0; i < meshlet.vertexCount; i++ )
+          localIndex[mesh->meshletVertices[meshlet.vertexOffset + i] - submesh.firstVertex] = -1;
+        finishMeshlet( *mesh, meshlet );
+        meshlet.vertexOffset = mesh->meshletVertices.size();
+        meshlet.vertexCount = 0;
+        meshlet.triangleOffset = mesh->meshletTriangles.size();
+        meshlet.triangleCount = 0;
+      }
+      for( int k = 0; k < 3; k++ ){
+        int & local = localIndex[triangle[k]];
+        if( local < 0 ){
+          local = meshlet.vertexCount++;
+          mesh->meshletVertices.push_back( submesh.firstVertex + triangle[k] );
+        }
+        mesh->meshletTriangles.push_back( (unsigned char)local );
+      }
+      meshlet.triangleCount++;
+    }
+    finishMeshlet( *mesh, meshlet );
+  }
+  //keep the following block 4 byte aligned
+  while( mesh->meshletTriangles.size() % 4 )
+    mesh->meshletTriangles.push_back( 0 );
+}
+
+//--------------------------------------------------------------------------------------------------
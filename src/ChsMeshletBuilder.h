@@ -0,0 +1,21 @@
+#ifndef _CHSMESHLETBUILDER_H
+#define _CHSMESHLETBUILDER_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+enum{
+  CHS_MESHLET_MAX_VERTICES = 64,
+  CHS_MESHLET_MAX_TRIANGLES = 124,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Cuts every submesh into meshlets following the current index order, so it should run after
+//	the vertex cache pass. maxVertices can not exceed 255.
+//--------------------------------------------------------------------------------------------------
+void buildMeshlets( ChsMeshSharedPtr & mesh, int maxVertices = CHS_MESHLET_MAX_VERTICES,
+                    int maxTriangles = CHS_MESHLET_MAX_TRIANGLES );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMESHLETBUILDER_H
@@ -0,0 +1,36 @@
+#include "ChsModelFormat.h"
+
+//--------------------------------------------------------------------------------------------------
+const char * const chsAttributeNames[] = {
+  "position",
+  "normal",
+  "texcoord0",
+  "vertexColor",
+  "tangent",
+};
+
+const char * const chsAttributeTypeNames[] = {
+  "GL_FLOAT",
+  "GL_HALF_FLOAT",
+  "GL_UNSIGNED_SHORT",
+  "GL_SHORT",
+  "GL_UNSIGNED_BYTE",
+  "GL_BYTE",
+};
+
+//--------------------------------------------------------------------------------------------------
+unsigned long long chsMeshIdHash( const char * id ){
+  unsigned long long hash = 14695981039346656037ULL;
+  for( const unsigned char * c = reinterpret_cast<const unsigned char *>( id ); *c; c++ ){
+    hash ^= *c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool isMeshEntryLess( const ChsMeshDirectoryEntry & a, const ChsMeshDirectoryEntry & b ){
+  return a.idHash != b.idHash ? a.idHash < b.idHash : a.mesh < b.mesh;
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,104 @@
+#ifndef _CHSMODELFORMAT_H
+#define _CHSMODELFORMAT_H
+//--------------------------------------------------------------------------------------------------
+//	.chsmodel version 2: a fixed header, chunks at aligned offsets, then the table of contents the
+//	header points to, last so a writer can stream the chunks out as they are built. Every chunk
+//	is one payload of the old layout ( the xml, a vertex block, an index block, ... ) without its
+//	size prefix, tagged with a type and the ChsMesh element it belongs to, so a loader can map the
+//	file and hand chunk pointers straight to the gpu. Little endian throughout.
+//	Version 1 files start with the same magic and go on with the xml size instead.
+//--------------------------------------------------------------------------------------------------
+#define CHS_FOURCC( a, b, c, d ) ( (unsigned int)(a) | ( (unsigned int)(b) << 8 ) | \
+                                   ( (unsigned int)(c) << 16 ) | ( (unsigned int)(d) << 24 ) )
+
+enum{
+  CHS_MODEL_VERSION = 2,
+  CHS_MODEL_ALIGNMENT = 64,
+  CHS_MODEL_PAGE_ALIGNMENT = 4096,
+};
+
+static const unsigned int CHS_NO_MESH = 0xffffffff;
+
+enum ChsChunkType{
+  CHS_CHUNK_XML = CHS_FOURCC( 'X', 'M', 'L', ' ' ),
+  CHS_CHUNK_VERTEX = CHS_FOURCC( 'V', 'E', 'R', 'T' ),
+  CHS_CHUNK_INDEX = CHS_FOURCC( 'I', 'N', 'D', 'X' ),
+  CHS_CHUNK_MESHLET = CHS_FOURCC( 'M', 'L', 'E', 'T' ),
+  CHS_CHUNK_MESHLET_VERTEX = CHS_FOURCC( 'M', 'L', 'V', 'X' ),
+  CHS_CHUNK_MESHLET_TRIANGLE = CHS_FOURCC( 'M', 'L', 'T', 'R' ),
+  CHS_CHUNK_LOD_INDEX = CHS_FOURCC( 'L', 'O', 'D', 'I' ),
+  CHS_CHUNK_DEPTH_POSITION = CHS_FOURCC( 'D', 'P', 'O', 'S' ),
+  CHS_CHUNK_DEPTH_INDEX = CHS_FOURCC( 'D', 'I', 'D', 'X' ),
+  CHS_CHUNK_MESH_DIRECTORY = CHS_FOURCC( 'M', 'D', 'I', 'R' ),
+};
+
+//--------------------------------------------------------------------------------------------------
+//	An lz4 chunk holds a uint32 count, that many ChsCompressedChunk sizes, then their data
+//--------------------------------------------------------------------------------------------------
+enum ChsChunkFlag{
+  CHS_CHUNK_LZ4 = 1,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	names in the xml part, indexed by ChsVertexAttributeId and ChsVertexAttributeType
+//--------------------------------------------------------------------------------------------------
+extern const char * const chsAttributeNames[];
+extern const char * const chsAttributeTypeNames[];
+
+#define CHS_ENCODING_VERTEX_CODEC "chsVertexCodec"
+#define CHS_ENCODING_INDEX_CODEC "chsIndexCodec"
+#define CHS_ENCODING_GEOMETRY_CODEC "chsGeometryCodec"
+
+//--------------------------------------------------------------------------------------------------
+struct ChsModelHeader{
+  char magic[4];                  //"chmo"
+  unsigned int version;
+  unsigned int headerSize;        //sizeof( ChsModelHeader ), later versions may append fields
+  unsigned int alignment;         //every chunk offset is a multiple of it
+  unsigned long long tocOffset;   //chunkCount ChsChunkEntry from here
+  unsigned int chunkCount;
+  unsigned int flags;
+};
+
+struct ChsChunkEntry{
+  unsigned int type;
+  unsigned int mesh;              //ChsMesh element index, CHS_NO_MESH for model chunks
+  unsigned int level;             //lod level of lod chunks, 0 otherwise
+  unsigned int flags;
+  unsigned long long offset;      //from the start of the file
+  unsigned long long size;        //bytes in the file
+  unsigned long long uncompressedSize;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	The mesh directory chunk, one entry per ChsMesh element sorted by idHash then mesh. The chunks
+//	of a mesh follow each other, so a runtime that read the header, the table of contents and this
+//	chunk once loads any mesh with a binary search and a single read of offset, size. Never lz4.
+//--------------------------------------------------------------------------------------------------
+enum ChsMeshEntryFlag{
+  CHS_MESH_NO_BOUNDS = 1,         //only set on entries a reader made up for older files
+};
+
+struct ChsMeshDirectoryEntry{
+  unsigned long long idHash;      //chsMeshIdHash of the element id
+  unsigned int mesh;
+  unsigned int firstChunk;        //table of contents entries of the mesh
+  unsigned int chunkCount;
+  unsigned int flags;
+  unsigned long long offset;      //from the first chunk start to the last chunk end
+  unsigned long long size;
+  unsigned long long uncompressedSize;  //of all its chunks
+  float boundsMin[3];             //positions before the mesh transform
+  float boundsMax[3];
+};
+
+//--------------------------------------------------------------------------------------------------
+//	64 bit fnv-1a
+//--------------------------------------------------------------------------------------------------
+unsigned long long chsMeshIdHash( const char * id );
+//the directory order
+bool isMeshEntryLess( const ChsMeshDirectoryEntry & a, const ChsMeshDirectoryEntry & b );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMODELFORMAT_H
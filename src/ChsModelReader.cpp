@@ -0,0 +1,784 @@
+#include <math.h>
+#include <limits.h>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ChsModelReader.h"
+#include "ChsChunkCompressor.h"
+#include "ChsVertexEncoder.h"
+#include "ChsIndexCodec.h"
+#include "ChsVertexCodec.h"
+#include "ChsGeometryCodec.h"
+#include "tinyxml2.h"
+using namespace tinyxml2;
+
+//--------------------------------------------------------------------------------------------------
+ChsModelReader::ChsModelReader( void ) : mapping( NULL ), fileSize( 0 ), fileVersion( 0 ){
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsModelReader::~ChsModelReader( void ){
+  close();
+}
+
+//--------------------------------------------------------------------------------------------------
+void ChsModelReader::close( void ){
+  if( mapping != NULL )
+    munmap( const_cast<unsigned char *>( mapping ), fileSize );
+  mapping = NULL;
+  fileSize = 0;
+  fileVersion = 0;
+  xmlText.clear();
+  chunks.clear();
+  meshes.clear();
+  directory.clear();
+  decodedBuffers.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::open( const char * path ){
+  close();
+  int file = ::open( path, O_RDONLY );
+  if( file < 0 )
+    return false;
+  struct stat status;
+  if( fstat( file, &status ) != 0 || status.st_size < 8 ){
+    ::close( file );
+    return false;
+  }
+  void * address = mmap( NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+  //the mapping keeps the file alive
+  ::close( file );
+  if( address == MAP_FAILED )
+    return false;
+  mapping = static_cast<const unsigned char *>( address );
+  fileSize = status.st_size;
+  //version 1 has the xml size where version 2 has its version, never as small as 2
+  unsigned int version;
+  memcpy( &version, mapping + 4, sizeof( version ) );
+  bool isRead = memcmp( mapping, "chmo", 4 ) == 0 &&
+                ( version == CHS_MODEL_VERSION ? readContainer() : readVersion1() ) && readMeshes() &&
+                readDirectory();
+  if( !isRead )
+    close();
+  return isRead;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::readContainer( void ){
+  ChsModelHeader header;
+  if( fileSize < sizeof( header ) )
+    return false;
+  memcpy( &header, mapping, sizeof( header ) );
+  if( header.headerSize < sizeof( header ) || header.tocOffset > fileSize ||
+      header.chunkCount > ( fileSize - header.tocOffset ) / sizeof( ChsChunkEntry ) )
+    return false;
+  fileVersion = header.version;
+  chunks.resize( header.chunkCount );
+  for( size_t i = 0; i < chunks.size(); i++ ){
+    Chunk & chunk = chunks[i];
+    memcpy( &chunk.entry, mapping + header.tocOffset + i * sizeof( ChsChunkEntry ), sizeof( ChsChunkEntry ) );
+    if( chunk.entry.offset > fileSize || chunk.entry.size > fileSize - chunk.entry.offset )
+      return false;
+    chunk.data = mapping + chunk.entry.offset;
+  }
+  int xmlChunk = findChunk( CHS_CHUNK_XML, CHS_NO_MESH, 0 );
+  if( xmlChunk < 0 || ( chunks[xmlChunk].entry.flags & CHS_CHUNK_LZ4 ) )
+    return false;
+  xmlText.assign( reinterpret_cast<const char *>( chunks[xmlChunk].data ), chunks[xmlChunk].entry.size );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the blocks follow the xml in the order ChaosExport writes them, the xml tells which are there
+//--------------------------------------------------------------------------------------------------
+class ChsBlockWalker{
+public:
+  ChsBlockWalker( const unsigned char * data, size_t size ) : data( data ), size( size ), offset( 0 ){}
+  bool next( const unsigned char *& block, size_t & blockSize ){
+    int value;
+    if( size - offset < sizeof( value ) )
+      return false;
+    memcpy( &value, data + offset, sizeof( value ) );
+    offset += sizeof( value );
+    if( value < 0 || (size_t)value > size - offset )
+      return false;
+    block = data + offset;
+    blockSize = value;
+    offset += value;
+    return true;
+  }
+private:
+  const unsigned char * data;
+  size_t size;
+  size_t offset;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	sum of the chunk sizes, ULLONG_MAX when it does not fit in a size_t or a chunk claims more than
+//	lz4 can expand to, a sequence never gives more than 255 bytes per input byte
+//--------------------------------------------------------------------------------------------------
+static unsigned long long inflatedSize( const std::vector<ChsCompressedChunk> & table ){
+  size_t size = 0;
+  for( size_t i = 0; i < table.size(); i++ ){
+    if( table[i].uncompressedSize > table[i].compressedSize * 255ULL + 64 ||
+        table[i].uncompressedSize > (size_t)-1 - size )
+      return ULLONG_MAX;
+    size += table[i].uncompressedSize;
+  }
+  return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::readVersion1( void ){
+  int xmlSize;
+  memcpy( &xmlSize, mapping + 4, sizeof( xmlSize ) );
+  if( xmlSize <= 0 || (size_t)xmlSize > fileSize - 8 )
+    return false;
+  const char * xml = reinterpret_cast<const char *>( mapping + 8 );
+  xmlText.assign( xml, strnlen( xml, xmlSize ) );
+  fileVersion = 1;
+  XMLDocument document;
+  if( document.Parse( xmlText.c_str() ) != XML_NO_ERROR || !document.FirstChildElement( "ChsModel" ) )
+    return false;
+  const XMLElement * modelElement = document.FirstChildElement( "ChsModel" );
+  const unsigned char * binaryPart = mapping + 8 + xmlSize;
+  size_t binarySize = fileSize - 8 - xmlSize;
+  //a compressed binary part is inflated whole, version 1 has no finer unit
+  const char * compression = modelElement->Attribute( "compression" );
+  if( compression != NULL ){
+    if( strcmp( compression, "lz4" ) != 0 )
+      return false;
+    ChsBlockWalker walker( binaryPart, binarySize );
+    const unsigned char * table, * compressed;
+    size_t tableSize, compressedSize;
+    int uncompressedSize = modelElement->IntAttribute( "uncompressedSize" );
+    if( !walker.next( table, tableSize ) || !walker.next( compressed, compressedSize ) || uncompressedSize < 0 )
+      return false;
+    std::vector<ChsCompressedChunk> chunkTable( tableSize / sizeof( ChsCompressedChunk ) );
+    memcpy( chunkTable.data(), table, chunkTable.size() * sizeof( ChsCompressedChunk ) );
+    if( inflatedSize( chunkTable ) != (unsigned long long)uncompressedSize )
+      return false;
+    std::vector<unsigned char> & inflated = decodedBuffers[std::make_pair( -1, 0 )];
+    inflated.resize( uncompressedSize );
+    if( !decompressChunks( inflated.data(), inflated.size(), chunkTable.data(), chunkTable.size(),
+                           compressed, compressedSize ) )
+      return false;
+    binaryPart = inflated.data();
+    binarySize = inflated.size();
+  }
+  ChsBlockWalker walker( binaryPart, binarySize );
+  unsigned int meshIdx = 0;
+  for( const XMLElement * meshElement = modelElement->FirstChildElement( "ChsMesh" ); meshElement != NULL;
+       meshElement = meshElement->NextSiblingElement( "ChsMesh" ), meshIdx++ ){
+    std::vector<unsigned int> types;
+    std::vector<unsigned int> levels;
+    types.push_back( CHS_CHUNK_VERTEX );
+    types.push_back( CHS_CHUNK_INDEX );
+    if( meshElement->FirstChildElement( "ChsMeshletBuffer" ) ){
+      types.push_back( CHS_CHUNK_MESHLET );
+      types.push_back( CHS_CHUNK_MESHLET_VERTEX );
+      types.push_back( CHS_CHUNK_MESHLET_TRIANGLE );
+    }
+    levels.resize( types.size(), 0 );
+    unsigned int level = 1;
+    for( const XMLElement * lodElement = meshElement->FirstChildElement( "ChsLod" ); lodElement != NULL;
+         lodElement = lodElement->NextSiblingElement( "ChsLod" ) ){
+      types.push_back( CHS_CHUNK_LOD_INDEX );
+      levels.push_back( level++ );
+    }
+    if( meshElement->FirstChildElement( "ChsDepthMesh" ) ){
+      types.push_back( CHS_CHUNK_DEPTH_POSITION );
+      types.push_back( CHS_CHUNK_DEPTH_INDEX );
+      levels.resize( types.size(), 0 );
+    }
+    for( size_t i = 0; i < types.size(); i++ ){
+      Chunk chunk;
+      size_t size;
+      if( !walker.next( chunk.data, size ) )
+        return false;
+      memset( &chunk.entry, 0, sizeof( chunk.entry ) );
+      chunk.entry.type = types[i];
+      chunk.entry.mesh = meshIdx;
+      chunk.entry.level = levels[i];
+      chunk.entry.size = chunk.entry.uncompressedSize = size;
+      //blocks of an inflated binary part have no place in the file
+      chunk.entry.offset = compression != NULL ? 0 : chunk.data - mapping;
+      chunks.push_back( chunk );
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+static int readEncoding( const XMLElement * element ){
+  const char * encoding = element->Attribute( "encoding" );
+  if( encoding == NULL )
+    return CHS_ENCODING_NONE;
+  if( strcmp( encoding, CHS_ENCODING_VERTEX_CODEC ) == 0 )
+    return CHS_ENCODING_VERTEX;
+  if( strcmp( encoding, CHS_ENCODING_INDEX_CODEC ) == 0 )
+    return CHS_ENCODING_INDEX;
+  if( strcmp( encoding, CHS_ENCODING_GEOMETRY_CODEC ) == 0 )
+    return CHS_ENCODING_GEOMETRY;
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+static int findName( const char * const * names, int count, const char * name ){
+  for( int i = 0; name != NULL && i < count; i++ ){
+    if( strcmp( names[i], name ) == 0 )
+      return i;
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+static void readFloats( const char * text, float * values, int count ){
+  for( int i = 0; i < count; i++ ){
+    char * end;
+    values[i] = text != NULL ? (float)strtod( text, &end ) : 0.0f;
+    text = text != NULL && end != text ? end : NULL;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void readSubmeshes( const XMLElement * parent, std::vector<ChsSubmesh> & submeshes ){
+  for( const XMLElement * element = parent->FirstChildElement( "ChsSubmesh" ); element != NULL;
+       element = element->NextSiblingElement( "ChsSubmesh" ) ){
+    ChsSubmesh submesh = { element->IntAttribute( "firstVertex" ), element->IntAttribute( "vertexCount" ),
+                           element->IntAttribute( "firstIndex" ), element->IntAttribute( "indexCount" ),
+                           element->IntAttribute( "material" ) };
+    submeshes.push_back( submesh );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	every range has to lie inside the buffers, raw index buffers are read through them unchecked
+//--------------------------------------------------------------------------------------------------
+static bool areRangesValid( const std::vector<ChsSubmesh> & submeshes, int indexCount, int vertexCount ){
+  for( size_t i = 0; i < submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = submeshes[i];
+    if( submesh.firstIndex < 0 || submesh.indexCount < 0 || submesh.indexCount > indexCount - submesh.firstIndex ||
+        submesh.firstVertex < 0 || submesh.vertexCount < 0 || submesh.vertexCount > vertexCount - submesh.firstVertex )
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+static bool readMesh( const XMLElement * meshElement, ChsModelMesh & mesh ){
+  const char * id = meshElement->Attribute( "id" );
+  mesh.id = id != NULL ? id : "";
+  for( const XMLElement * element = meshElement->FirstChildElement( "ChsAttribute" ); element != NULL;
+       element = element->NextSiblingElement( "ChsAttribute" ) ){
+    ChsVertexAttribute attribute = { findName( chsAttributeNames, CHS_ATTRIBUTE_MAX, element->Attribute( "id" ) ),
+                                     element->IntAttribute( "stride" ),
+                                     findName( chsAttributeTypeNames, CHS_TYPE_MAX, element->Attribute( "type" ) ),
+                                     element->BoolAttribute( "normalized" ), element->IntAttribute( "offset" ),
+                                     element->IntAttribute( "stream" ) };
+    if( attribute.id < 0 || attribute.type < 0 || attribute.components < 1 || attribute.components > 4 )
+      return false;
+    mesh.attributes.push_back( attribute );
+  }
+  for( const XMLElement * element = meshElement->FirstChildElement( "ChsVertexStream" ); element != NULL;
+       element = element->NextSiblingElement( "ChsVertexStream" ) ){
+    ChsVertexStream stream = { element->IntAttribute( "offset" ), element->IntAttribute( "stride" ) };
+    mesh.streams.push_back( stream );
+  }
+  const XMLElement * vertexElement = meshElement->FirstChildElement( "ChsVertexBuffer" );
+  const XMLElement * indexElement = meshElement->FirstChildElement( "ChsIndexBuffer" );
+  if( vertexElement == NULL || indexElement == NULL )
+    return false;
+  mesh.vertexCount = vertexElement->IntAttribute( "vertexCount" );
+  mesh.vertexSize = vertexElement->IntAttribute( "vertexSize" );
+  mesh.vertexEncoding = readEncoding( vertexElement );
+  mesh.isQuantized = vertexElement->Attribute( "positionScale" ) != NULL;
+  readFloats( vertexElement->Attribute( "positionScale" ), mesh.positionScale, 3 );
+  readFloats( vertexElement->Attribute( "positionOffset" ), mesh.positionOffset, 3 );
+  if( mesh.streams.empty() ){
+    ChsVertexStream stream = { 0, mesh.vertexSize };
+    mesh.streams.push_back( stream );
+  }
+  mesh.indexCount = indexElement->IntAttribute( "count" );
+  mesh.isShort = indexElement->BoolAttribute( "isShort" );
+  mesh.indexEncoding = readEncoding( indexElement );
+  readSubmeshes( meshElement, mesh.submeshes );
+  if( mesh.submeshes.empty() ){
+    ChsSubmesh submesh = { 0, mesh.vertexCount, 0, mesh.indexCount, 0 };
+    mesh.submeshes.push_back( submesh );
+  }
+  if( mesh.vertexCount < 0 || mesh.indexCount < 0 ||
+      !areRangesValid( mesh.submeshes, mesh.indexCount, mesh.vertexCount ) )
+    return false;
+  for( const XMLElement * element = meshElement->FirstChildElement( "ChsLod" ); element != NULL;
+       element = element->NextSiblingElement( "ChsLod" ) ){
+    ChsModelLod lod;
+    lod.indexCount = element->IntAttribute( "count" );
+    lod.encoding = readEncoding( element );
+    readSubmeshes( element, lod.submeshes );
+    if( lod.submeshes.empty() ){
+      ChsSubmesh submesh = { 0, mesh.vertexCount, 0, lod.indexCount, 0 };
+      lod.submeshes.push_back( submesh );
+    }
+    //lod ranges only carry their indices, the vertex ranges are the mesh ones
+    for( size_t i = 0; i < lod.submeshes.size() && i < mesh.submeshes.size(); i++ ){
+      lod.submeshes[i].firstVertex = mesh.submeshes[i].firstVertex;
+      lod.submeshes[i].vertexCount = mesh.submeshes[i].vertexCount;
+    }
+    if( lod.indexCount < 0 || !areRangesValid( lod.submeshes, lod.indexCount, mesh.vertexCount ) )
+      return false;
+    mesh.lods.push_back( lod );
+  }
+  mesh.hasMeshlets = meshElement->FirstChildElement( "ChsMeshletBuffer" ) != NULL;
+  mesh.hasDepthMesh = meshElement->FirstChildElement( "ChsDepthMesh" ) != NULL;
+  const XMLElement * transformElement = meshElement->FirstChildElement( "ChsMatrix" );
+  const XMLNode * transformText = transformElement != NULL ? transformElement->FirstChild() : NULL;
+  readFloats( transformText != NULL && transformText->ToText() != NULL ? transformText->Value() : NULL,
+              &mesh.transform[0][0], 16 );
+  return mesh.vertexSize >= 0 && mesh.vertexEncoding >= 0 && mesh.indexEncoding >= 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::readMeshes( void ){
+  XMLDocument document;
+  if( document.Parse( xmlText.c_str() ) != XML_NO_ERROR )
+    return false;
+  const XMLElement * modelElement = document.FirstChildElement( "ChsModel" );
+  if( modelElement == NULL )
+    return false;
+  for( const XMLElement * meshElement = modelElement->FirstChildElement( "ChsMesh" ); meshElement != NULL;
+       meshElement = meshElement->NextSiblingElement( "ChsMesh" ) ){
+    meshes.push_back( ChsModelMesh() );
+    if( !readMesh( meshElement, meshes.back() ) )
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the directory chunk is trusted as far as it points inside the file and at known meshes
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::readDirectory( void ){
+  int chunkIdx = findChunk( CHS_CHUNK_MESH_DIRECTORY, CHS_NO_MESH, 0 );
+  if( chunkIdx >= 0 ){
+    const ChsChunkEntry & entry = chunks[chunkIdx].entry;
+    if( entry.flags != 0 || entry.size % sizeof( ChsMeshDirectoryEntry ) != 0 )
+      return false;
+    directory.resize( entry.size / sizeof( ChsMeshDirectoryEntry ) );
+    if( !directory.empty() )
+      memcpy( directory.data(), chunks[chunkIdx].data, entry.size );
+    for( size_t i = 0; i < directory.size(); i++ ){
+      const ChsMeshDirectoryEntry & meshEntry = directory[i];
+      if( meshEntry.mesh >= meshes.size() || meshEntry.offset > fileSize || meshEntry.size > fileSize - meshEntry.offset ||
+          ( i > 0 && isMeshEntryLess( meshEntry, directory[i - 1] ) ) )
+        return false;
+    }
+    return true;
+  }
+  //version 1 blocks and older version 2 files also keep the chunks of a mesh together, a
+  //compressed version 1 file has no range per mesh and gets empty ones
+  directory.resize( meshes.size() );
+  for( size_t meshIdx = 0; meshIdx < meshes.size(); meshIdx++ ){
+    ChsMeshDirectoryEntry & meshEntry = directory[meshIdx];
+    memset( &meshEntry, 0, sizeof( meshEntry ) );
+    meshEntry.idHash = chsMeshIdHash( meshes[meshIdx].id.c_str() );
+    meshEntry.mesh = meshIdx;
+    meshEntry.flags = CHS_MESH_NO_BOUNDS;
+    for( size_t i = 0; i < chunks.size(); i++ ){
+      const Chunk & chunk = chunks[i];
+      if( chunk.entry.mesh != meshIdx )
+        continue;
+      if( meshEntry.chunkCount == 0 ){
+        meshEntry.firstChunk = i;
+        meshEntry.offset = chunk.entry.offset;
+      }
+      meshEntry.chunkCount = i - meshEntry.firstChunk + 1;
+      if( chunk.entry.offset != 0 )
+        meshEntry.size = chunk.entry.offset + chunk.entry.size - meshEntry.offset;
+      meshEntry.uncompressedSize += chunk.entry.uncompressedSize;
+    }
+  }
+  std::sort( directory.begin(), directory.end(), isMeshEntryLess );
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+const ChsMeshDirectoryEntry * ChsModelReader::findMesh( const char * id )const{
+  unsigned long long hash = chsMeshIdHash( id );
+  size_t low = 0;
+  size_t high = directory.size();
+  while( low < high ){
+    size_t middle = ( low + high ) / 2;
+    if( directory[middle].idHash < hash )
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  //different ids may share a hash
+  for( ; low < directory.size() && directory[low].idHash == hash; low++ ){
+    if( meshes[directory[low].mesh].id == id )
+      return &directory[low];
+  }
+  return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+int ChsModelReader::findChunk( unsigned int type, unsigned int meshIdx, unsigned int level )const{
+  for( size_t i = 0; i < chunks.size(); i++ ){
+    const ChsChunkEntry & entry = chunks[i].entry;
+    if( entry.type == type && entry.mesh == meshIdx && entry.level == level )
+      return i;
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+std::vector<unsigned char> & ChsModelReader::decodedBuffer( int chunkIdx, int part, bool & isNew ){
+  std::pair<int, int> key( chunkIdx, part );
+  isNew = decodedBuffers.find( key ) == decodedBuffers.end();
+  return decodedBuffers[key];
+}
+
+//--------------------------------------------------------------------------------------------------
+//	an lz4 chunk is a uint32 count, the ChsCompressedChunk table, then the data
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::chunk( unsigned int type, unsigned int meshIdx, unsigned int level, ChsBufferView & view ){
+  int chunkIdx = findChunk( type, meshIdx, level );
+  if( chunkIdx < 0 )
+    return false;
+  const Chunk & source = chunks[chunkIdx];
+  if( !( source.entry.flags & CHS_CHUNK_LZ4 ) ){
+    view.data = source.data;
+    view.size = source.entry.size;
+    return true;
+  }
+  bool isNew;
+  std::vector<unsigned char> & inflated = decodedBuffer( chunkIdx, 0, isNew );
+  if( isNew ){
+    unsigned int count;
+    if( source.entry.size < sizeof( count ) )
+      return false;
+    memcpy( &count, source.data, sizeof( count ) );
+    size_t tableSize = sizeof( count ) + (size_t)count * sizeof( ChsCompressedChunk );
+    if( count > source.entry.size / sizeof( ChsCompressedChunk ) || tableSize > source.entry.size )
+      return false;
+    std::vector<ChsCompressedChunk> table( count );
+    memcpy( table.data(), source.data + sizeof( count ), count * sizeof( ChsCompressedChunk ) );
+    //the size comes from the file, only allocate what the table agrees on
+    if( inflatedSize( table ) != source.entry.uncompressedSize ){
+      decodedBuffers.erase( std::make_pair( chunkIdx, 0 ) );
+      return false;
+    }
+    inflated.resize( source.entry.uncompressedSize );
+    if( !decompressChunks( inflated.data(), inflated.size(), table.data(), count, source.data + tableSize,
+                           source.entry.size - tableSize ) ){
+      decodedBuffers.erase( std::make_pair( chunkIdx, 0 ) );
+      return false;
+    }
+  }
+  view.data = inflated.data();
+  view.size = inflated.size();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	codec buffers are streams of uint32 size, data, padding to 4 bytes
+//--------------------------------------------------------------------------------------------------
+static bool nextStream( const unsigned char *& position, const unsigned char * end,
+                        const unsigned char *& stream, size_t & streamSize ){
+  unsigned int size;
+  if( (size_t)( end - position ) < sizeof( size ) )
+    return false;
+  memcpy( &size, position, sizeof( size ) );
+  position += sizeof( size );
+  if( size > (size_t)( end - position ) )
+    return false;
+  stream = position;
+  streamSize = size;
+  size_t padded = ( size + 3 ) & ~3u;
+  position += padded < (size_t)( end - position ) ? padded : end - position;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::vertices( int meshIdx, ChsBufferView & view ){
+  const ChsModelMesh & mesh = meshes[meshIdx];
+  if( !chunk( CHS_CHUNK_VERTEX, meshIdx, 0, view ) )
+    return false;
+  if( mesh.vertexEncoding == CHS_ENCODING_NONE )
+    return view.size >= (size_t)mesh.vertexCount * mesh.vertexSize;
+  if( mesh.vertexEncoding == CHS_ENCODING_GEOMETRY && !decodeGeometryMesh( meshIdx ) )
+    return false;
+  bool isNew;
+  int chunkIdx = findChunk( CHS_CHUNK_VERTEX, meshIdx, 0 );
+  std::vector<unsigned char> & decoded = decodedBuffer( chunkIdx, 1, isNew );
+  if( isNew ){
+    //one codec stream per vertex stream
+    decoded.resize( (size_t)mesh.vertexCount * mesh.vertexSize );
+    const unsigned char * position = static_cast<const unsigned char *>( view.data );
+    const unsigned char * end = position + view.size;
+    for( size_t i = 0; i < mesh.streams.size(); i++ ){
+      const ChsVertexStream & stream = mesh.streams[i];
+      const unsigned char * data;
+      size_t size;
+      if( !nextStream( position, end, data, size ) ||
+          (size_t)stream.offset + (size_t)stream.stride * mesh.vertexCount > decoded.size() ||
+          decodeVertexBuffer( decoded.data() + stream.offset, mesh.vertexCount, stream.stride, data, size ) != 0 ){
+        decodedBuffers.erase( std::make_pair( chunkIdx, 1 ) );
+        return false;
+      }
+    }
+  }
+  view.data = decoded.data();
+  view.size = decoded.size();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	every submesh is one index codec stream, its indices relative to its first vertex
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::decodeIndexRanges( const ChsBufferView & source, const std::vector<ChsSubmesh> & submeshes,
+                                        int indexCount, bool isShort, std::vector<unsigned char> & indices ){
+  int indexSize = isShort ? sizeof( unsigned short ) : sizeof( unsigned int );
+  indices.assign( (size_t)indexCount * indexSize, 0 );
+  const unsigned char * position = static_cast<const unsigned char *>( source.data );
+  const unsigned char * end = position + source.size;
+  for( size_t i = 0; i < submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = submeshes[i];
+    const unsigned char * data;
+    size_t size;
+    if( submesh.firstIndex < 0 || submesh.indexCount < 0 || submesh.firstIndex + submesh.indexCount > indexCount ||
+        !nextStream( position, end, data, size ) ||
+        decodeIndexBuffer( indices.data() + (size_t)submesh.firstIndex * indexSize, submesh.indexCount, indexSize,
+                           data, size ) != 0 )
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::indices( int meshIdx, ChsBufferView & view ){
+  const ChsModelMesh & mesh = meshes[meshIdx];
+  if( mesh.indexEncoding == CHS_ENCODING_GEOMETRY ){
+    if( !decodeGeometryMesh( meshIdx ) )
+      return false;
+    bool isNew;
+    std::vector<unsigned char> & decoded = decodedBuffer( findChunk( CHS_CHUNK_VERTEX, meshIdx, 0 ), 2, isNew );
+    view.data = decoded.data();
+    view.size = decoded.size();
+    return true;
+  }
+  size_t indexSize = mesh.isShort ? sizeof( unsigned short ) : sizeof( unsigned int );
+  if( !chunk( CHS_CHUNK_INDEX, meshIdx, 0, view ) )
+    return false;
+  if( mesh.indexEncoding == CHS_ENCODING_NONE )
+    return view.size >= mesh.indexCount * indexSize;
+  bool isNew;
+  int chunkIdx = findChunk( CHS_CHUNK_INDEX, meshIdx, 0 );
+  std::vector<unsigned char> & decoded = decodedBuffer( chunkIdx, 1, isNew );
+  if( isNew && !decodeIndexRanges( view, mesh.submeshes, mesh.indexCount, mesh.isShort, decoded ) ){
+    decodedBuffers.erase( std::make_pair( chunkIdx, 1 ) );
+    return false;
+  }
+  view.data = decoded.data();
+  view.size = decoded.size();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::lodIndices( int meshIdx, int level, ChsBufferView & view ){
+  const ChsModelMesh & mesh = meshes[meshIdx];
+  if( level < 1 || level > (int)mesh.lods.size() || !chunk( CHS_CHUNK_LOD_INDEX, meshIdx, level, view ) )
+    return false;
+  const ChsModelLod & lod = mesh.lods[level - 1];
+  size_t indexSize = mesh.isShort ? sizeof( unsigned short ) : sizeof( unsigned int );
+  if( lod.encoding == CHS_ENCODING_NONE )
+    return view.size >= lod.indexCount * indexSize;
+  bool isNew;
+  int chunkIdx = findChunk( CHS_CHUNK_LOD_INDEX, meshIdx, level );
+  std::vector<unsigned char> & decoded = decodedBuffer( chunkIdx, 1, isNew );
+  if( isNew && !decodeIndexRanges( view, lod.submeshes, lod.indexCount, mesh.isShort, decoded ) ){
+    decodedBuffers.erase( std::make_pair( chunkIdx, 1 ) );
+    return false;
+  }
+  view.data = decoded.data();
+  view.size = decoded.size();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	one stream per vertex range holding the lists of its submeshes, grouped like the encoder does;
+//	fills part 1 of the vertex chunk with the float vertices and part 2 with the indices
+//--------------------------------------------------------------------------------------------------
+bool ChsModelReader::decodeGeometryMesh( int meshIdx ){
+  const ChsModelMesh & mesh = meshes[meshIdx];
+  int chunkIdx = findChunk( CHS_CHUNK_VERTEX, meshIdx, 0 );
+  bool isNew;
+  decodedBuffer( chunkIdx, 1, isNew );
+  if( !isNew )
+    return true;
+  ChsBufferView view;
+  int stride = mesh.vertexSize / sizeof( float );
+  size_t indexSize = mesh.isShort ? sizeof( unsigned short ) : sizeof( unsigned int );
+  bool isDecoded = chunk( CHS_CHUNK_VERTEX, meshIdx, 0, view ) && !mesh.isQuantized && mesh.streams.size() == 1;
+  std::vector<unsigned char> & vertexData = decodedBuffer( chunkIdx, 1, isNew );
+  std::vector<unsigned char> & indexData = decodedBuffer( chunkIdx, 2, isNew );
+  vertexData.assign( (size_t)mesh.vertexCount * mesh.vertexSize, 0 );
+  indexData.assign( mesh.indexCount * indexSize, 0 );
+  const unsigned char * position = static_cast<const unsigned char *>( view.data );
+  const unsigned char * end = position + view.size;
+  int submeshCount = mesh.submeshes.size();
+  std::vector<bool> isDone( submeshCount, false );
+  std::vector<unsigned int> rangeIndices;
+  for( int i = 0; i < submeshCount && isDecoded; i++ ){
+    if( isDone[i] )
+      continue;
+    const ChsSubmesh & range = mesh.submeshes[i];
+    std::vector<int> members;
+    int rangeIndexCount = 0;
+    for( int j = i; j < submeshCount; j++ ){
+      const ChsSubmesh & submesh = mesh.submeshes[j];
+      if( !isDone[j] && submesh.firstVertex == range.firstVertex && submesh.vertexCount == range.vertexCount ){
+        members.push_back( j );
+        rangeIndexCount += submesh.indexCount;
+        isDone[j] = true;
+      }
+    }
+    const unsigned char * data;
+    size_t size;
+    rangeIndices.resize( rangeIndexCount );
+    isDecoded = range.firstVertex >= 0 && range.vertexCount >= 0 &&
+                range.firstVertex + range.vertexCount <= mesh.vertexCount && nextStream( position, end, data, size ) &&
+                decodeGeometry( reinterpret_cast<float *>( vertexData.data() ) + (size_t)range.firstVertex * stride,
+                                range.vertexCount, stride, rangeIndices.data(), rangeIndexCount, data, size ) == 0;
+    //back to the submesh places, lists come out in member order
+    const unsigned int * list = rangeIndices.data();
+    for( size_t k = 0; k < members.size() && isDecoded; k++ ){
+      const ChsSubmesh & submesh = mesh.submeshes[members[k]];
+      isDecoded = submesh.firstIndex >= 0 && submesh.firstIndex + submesh.indexCount <= mesh.indexCount;
+      for( int n = 0; n < submesh.indexCount && isDecoded; n++ ){
+        if( mesh.isShort )
+          reinterpret_cast<unsigned short *>( indexData.data() )[submesh.firstIndex + n] = list[n];
+        else
+          reinterpret_cast<unsigned int *>( indexData.data() )[submesh.firstIndex + n] = list[n];
+      }
+      list += submesh.indexCount;
+    }
+  }
+  if( !isDecoded ){
+    decodedBuffers.erase( std::make_pair( chunkIdx, 1 ) );
+    decodedBuffers.erase( std::make_pair( chunkIdx, 2 ) );
+  }
+  return isDecoded;
+}
+
+//--------------------------------------------------------------------------------------------------
+static float halfToFloat( unsigned short half ){
+  unsigned int sign = ( half & 0x8000 ) << 16;
+  unsigned int exponent = ( half >> 10 ) & 0x1f;
+  unsigned int mantissa = half & 0x3ff;
+  union{ float f; unsigned int u; } bits;
+  if( exponent == 0x1f )
+    bits.u = sign | 0x7f800000 | ( mantissa << 13 );
+  else if( exponent != 0 )
+    bits.u = sign | ( ( exponent + 127 - 15 ) << 23 ) | ( mantissa << 13 );
+  else{
+    //subnormal halves are normal floats
+    bits.f = mantissa * ( 1.0f / 16777216.0f );
+    bits.u |= sign;
+  }
+  return bits.f;
+}
+
+//--------------------------------------------------------------------------------------------------
+static float readComponent( const unsigned char * source, int type, bool normalized ){
+  switch( type ){
+    case CHS_TYPE_FLOAT:{
+      float value;
+      memcpy( &value, source, sizeof( value ) );
+      return value;
+    }
+    case CHS_TYPE_HALF_FLOAT:{
+      unsigned short value;
+      memcpy( &value, source, sizeof( value ) );
+      return halfToFloat( value );
+    }
+    case CHS_TYPE_UNSIGNED_SHORT:{
+      unsigned short value;
+      memcpy( &value, source, sizeof( value ) );
+      return normalized ? value / 65535.0f : value;
+    }
+    case CHS_TYPE_SHORT:{
+      short value;
+      memcpy( &value, source, sizeof( value ) );
+      return normalized ? ( value < -32767 ? -1.0f : value / 32767.0f ) : value;
+    }
+    case CHS_TYPE_UNSIGNED_BYTE:
+      return normalized ? source[0] / 255.0f : source[0];
+    case CHS_TYPE_BYTE:{
+      signed char value = (signed char)source[0];
+      return normalized ? ( value < -127 ? -1.0f : value / 127.0f ) : value;
+    }
+  }
+  return 0.0f;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the inverse of the octahedral fold in the vertex encoder
+//--------------------------------------------------------------------------------------------------
+static void decodeOctahedron( float u, float v, float * normal ){
+  float z = 1.0f - fabsf( u ) - fabsf( v );
+  if( z < 0.0f ){
+    float x = ( 1.0f - fabsf( v ) ) * ( u >= 0.0f ? 1.0f : -1.0f );
+    v = ( 1.0f - fabsf( u ) ) * ( v >= 0.0f ? 1.0f : -1.0f );
+    u = x;
+  }
+  float length = sqrtf( u * u + v * v + z * z );
+  float scale = length > 0.0f ? 1.0f / length : 0.0f;
+  normal[0] = u * scale;
+  normal[1] = v * scale;
+  normal[2] = z * scale;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool readVertexAttribute( const ChsModelMesh & mesh, const ChsBufferView & vertices, int attributeId,
+                          std::vector<float> & values, int components ){
+  const ChsVertexAttribute * attribute = NULL;
+  for( size_t i = 0; i < mesh.attributes.size(); i++ ){
+    if( mesh.attributes[i].id == attributeId )
+      attribute = &mesh.attributes[i];
+  }
+  if( attribute == NULL || attribute->stream < 0 || attribute->stream >= (int)mesh.streams.size() )
+    return false;
+  const ChsVertexStream & stream = mesh.streams[attribute->stream];
+  int typeSize = vertexAttributeTypeSize( attribute->type );
+  if( attribute->offset + attribute->components * typeSize > stream.stride ||
+      stream.offset + (size_t)stream.stride * mesh.vertexCount > vertices.size )
+    return false;
+  bool isOctahedral = attributeId == CHS_ATTRIBUTE_NORMAL && attribute->components == 2;
+  values.assign( (size_t)mesh.vertexCount * components, 0.0f );
+  const unsigned char * source = static_cast<const unsigned char *>( vertices.data ) + stream.offset +
+                                 attribute->offset;
+  for( int i = 0; i < mesh.vertexCount; i++, source += stream.stride ){
+    float value[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for( int k = 0; k < attribute->components; k++ )
+      value[k] = readComponent( source + k * typeSize, attribute->type, attribute->normalized );
+    if( isOctahedral )
+      decodeOctahedron( value[0], value[1], value );
+    if( attributeId == CHS_ATTRIBUTE_POSITION && mesh.isQuantized ){
+      for( int axis = 0; axis < 3; axis++ )
+        value[axis] = mesh.positionOffset[axis] + value[axis] * mesh.positionScale[axis];
+    }
+    for( int k = 0; k < components && k < 4; k++ )
+      values[(size_t)i * components + k] = value[k];
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
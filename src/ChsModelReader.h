@@ -0,0 +1,133 @@
+#ifndef _CHSMODELREADER_H
+#define _CHSMODELREADER_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "ChsModelFormat.h"
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Bytes inside the mapped file, or inside a buffer the reader decoded them into. Views into a
+//	version 1 file have no alignment, read them with memcpy
+//--------------------------------------------------------------------------------------------------
+struct ChsBufferView{
+  const void * data;
+  size_t size;
+};
+
+enum ChsModelEncoding{
+  CHS_ENCODING_NONE,
+  CHS_ENCODING_VERTEX,
+  CHS_ENCODING_INDEX,
+  CHS_ENCODING_GEOMETRY,
+};
+
+//--------------------------------------------------------------------------------------------------
+//	What the xml part says about one ChsMesh element, enough to read its buffers
+//--------------------------------------------------------------------------------------------------
+struct ChsModelLod{
+  int indexCount;
+  int encoding;
+  std::vector<ChsSubmesh> submeshes;
+};
+
+struct ChsModelMesh{
+  std::string id;
+  std::vector<ChsVertexAttribute> attributes;
+  std::vector<ChsVertexStream> streams;
+  int vertexCount;
+  int vertexSize;
+  int vertexEncoding;
+  bool isQuantized;
+  float positionScale[3];
+  float positionOffset[3];
+  int indexCount;
+  bool isShort;
+  int indexEncoding;
+  std::vector<ChsSubmesh> submeshes;
+  std::vector<ChsModelLod> lods;
+  bool hasMeshlets;
+  bool hasDepthMesh;
+  float transform[4][4];
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Maps a binary .chsmodel and hands out views into it. Plain chunks are never copied; lz4
+//	chunks and codec encoded buffers are decoded on first use and kept until close. Reads both
+//	container versions, version 1 through a table of contents built from its size prefixes,
+//	where views may be only byte aligned. Not thread safe.
+//--------------------------------------------------------------------------------------------------
+class ChsModelReader{
+public:
+  ChsModelReader( void );
+  ~ChsModelReader( void );
+  bool open( const char * path );
+  void close( void );
+  int version( void )const{
+    return fileVersion;
+  }
+  const std::string & xml( void )const{
+    return xmlText;
+  }
+  int meshCount( void )const{
+    return meshes.size();
+  }
+  const ChsModelMesh & mesh( int meshIdx )const{
+    return meshes[meshIdx];
+  }
+  size_t mappedSize( void )const{
+    return fileSize;
+  }
+  //binary search of the mesh directory, NULL when no ChsMesh element has that id; files written
+  //without a directory get one made up from the table of contents, without bounds
+  const ChsMeshDirectoryEntry * findMesh( const char * id )const;
+  //false when the file has no such chunk or it does not decompress
+  bool chunk( unsigned int type, unsigned int meshIdx, unsigned int level, ChsBufferView & view );
+  //vertexSize bytes per vertex in the stream layout of the attributes, indices 2 or 4 bytes by isShort
+  bool vertices( int meshIdx, ChsBufferView & view );
+  bool indices( int meshIdx, ChsBufferView & view );
+  //level counts from 1 like the lod chunks
+  bool lodIndices( int meshIdx, int level, ChsBufferView & view );
+
+private:
+  ChsModelReader( const ChsModelReader & );
+  ChsModelReader & operator=( const ChsModelReader & );
+  struct Chunk{
+    ChsChunkEntry entry;
+    const unsigned char * data;
+  };
+  bool readContainer( void );
+  bool readVersion1( void );
+  bool readMeshes( void );
+  bool readDirectory( void );
+  int findChunk( unsigned int type, unsigned int meshIdx, unsigned int level )const;
+  std::vector<unsigned char> & decodedBuffer( int chunkIdx, int part, bool & isNew );
+  bool decodeGeometryMesh( int meshIdx );
+  bool decodeIndexRanges( const ChsBufferView & source, const std::vector<ChsSubmesh> & submeshes, int indexCount,
+                          bool isShort, std::vector<unsigned char> & indices );
+
+  const unsigned char * mapping;
+  size_t fileSize;
+  int fileVersion;
+  std::string xmlText;
+  std::vector<Chunk> chunks;
+  std::vector<ChsModelMesh> meshes;
+  std::vector<ChsMeshDirectoryEntry> directory;
+  //decoded data by chunk and part, the inflated version 1 binary part under -1
+  std::map< std::pair<int, int>, std::vector<unsigned char> > decodedBuffers;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	One attribute of every vertex as floats whatever its stored type: quantized positions are
+//	scaled back, normalized integers mapped, octahedral normals unfolded. components per vertex in
+//	values, missing ones are 0. false when the mesh has no such attribute.
+//--------------------------------------------------------------------------------------------------
+bool readVertexAttribute( const ChsModelMesh & mesh, const ChsBufferView & vertices, int attributeId,
+                          std::vector<float> & values, int components );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMODELREADER_H
@@ -0,0 +1,124 @@
+#include <string.h>
+#include <algorithm>
+
+#include "ChsModelWriter.h"
+#include "ChsChunkCompressor.h"
+
+//--------------------------------------------------------------------------------------------------
+ChsModelWriter::ChsModelWriter( ChsOutputSink & sink ) : sink( sink ), offset( 0 ),
+                                                         alignment( CHS_MODEL_ALIGNMENT ), compressedChunkSize( 0 ){
+}
+
+//--------------------------------------------------------------------------------------------------
+void ChsModelWriter::pad( unsigned int boundary ){
+  static const unsigned char zeros[CHS_MODEL_PAGE_ALIGNMENT] = { 0 };
+  unsigned long long aligned = ( offset + boundary - 1 ) / boundary * boundary;
+  while( offset < aligned ){
+    size_t size = aligned - offset < sizeof( zeros ) ? aligned - offset : sizeof( zeros );
+    sink.write( zeros, size );
+    offset += size;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	the header is written again by finish, for now it only reserves the room
+//--------------------------------------------------------------------------------------------------
+void ChsModelWriter::begin( void ){
+  ChsModelHeader header;
+  memset( &header, 0, sizeof( header ) );
+  sink.write( &header, sizeof( header ) );
+  offset = sizeof( header );
+  entries.clear();
+  directory.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+//	an lz4 chunk is a uint32 count, the ChsCompressedChunk table, then the data; kept plain when
+//	that does not come out smaller
+//--------------------------------------------------------------------------------------------------
+void ChsModelWriter::addChunk( unsigned int type, unsigned int mesh, unsigned int level,
+                               const void * data, size_t size ){
+  ChsChunkEntry entry;
+  memset( &entry, 0, sizeof( entry ) );
+  entry.type = type;
+  entry.mesh = mesh;
+  entry.level = level;
+  entry.size = size;
+  entry.uncompressedSize = size;
+  std::vector<ChsCompressedChunk> table;
+  std::vector<unsigned char> compressed;
+  unsigned int count = 0;
+  //the xml and the directory are read before anything else, keep them plain
+  if( compressedChunkSize > 0 && type != CHS_CHUNK_XML && type != CHS_CHUNK_MESH_DIRECTORY && size > 0 ){
+    compressChunks( static_cast<const unsigned char *>( data ), size, compressedChunkSize, table, compressed );
+    count = table.size();
+    size_t compressedSize = sizeof( count ) + table.size() * sizeof( ChsCompressedChunk ) + compressed.size();
+    if( compressedSize < size ){
+      entry.size = compressedSize;
+      entry.flags |= CHS_CHUNK_LZ4;
+    }
+  }
+  pad( alignment );
+  entry.offset = offset;
+  if( entry.flags & CHS_CHUNK_LZ4 ){
+    sink.write( &count, sizeof( count ) );
+    sink.write( table.data(), table.size() * sizeof( ChsCompressedChunk ) );
+    sink.write( compressed.data(), compressed.size() );
+  }
+  else{
+    sink.write( data, size );
+  }
+  offset += entry.size;
+  entries.push_back( entry );
+}
+
+//--------------------------------------------------------------------------------------------------
+void ChsModelWriter::addMeshEntry( unsigned int mesh, const char * id,
+                                   const float boundsMin[3], const float boundsMax[3] ){
+  ChsMeshDirectoryEntry entry;
+  memset( &entry, 0, sizeof( entry ) );
+  entry.idHash = chsMeshIdHash( id );
+  entry.mesh = mesh;
+  unsigned int firstChunk = directory.empty() ? 0 : directory.back().firstChunk + directory.back().chunkCount;
+  for( unsigned int i = firstChunk; i < entries.size(); i++ ){
+    if( entries[i].mesh != mesh )
+      continue;
+    if( entry.chunkCount == 0 ){
+      entry.firstChunk = i;
+      entry.offset = entries[i].offset;
+    }
+    entry.chunkCount = i - entry.firstChunk + 1;
+    entry.size = entries[i].offset + entries[i].size - entry.offset;
+    entry.uncompressedSize += entries[i].uncompressedSize;
+  }
+  for( int i = 0; i < 3; i++ ){
+    entry.boundsMin[i] = boundsMin[i];
+    entry.boundsMax[i] = boundsMax[i];
+  }
+  directory.push_back( entry );
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ChsModelWriter::finish( void ){
+  if( !directory.empty() ){
+    //entries went in by mesh, which the next addMeshEntry relies on, so sort only now
+    std::sort( directory.begin(), directory.end(), isMeshEntryLess );
+    addChunk( CHS_CHUNK_MESH_DIRECTORY, CHS_NO_MESH, 0, directory.data(),
+              directory.size() * sizeof( ChsMeshDirectoryEntry ) );
+  }
+  ChsModelHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, "chmo", 4 );
+  header.version = CHS_MODEL_VERSION;
+  header.headerSize = sizeof( ChsModelHeader );
+  header.alignment = alignment;
+  header.chunkCount = entries.size();
+  //entries are 8 byte aligned like their 64 bit fields
+  pad( sizeof( unsigned long long ) );
+  header.tocOffset = offset;
+  sink.write( entries.data(), entries.size() * sizeof( ChsChunkEntry ) );
+  offset += entries.size() * sizeof( ChsChunkEntry );
+  return sink.patch( 0, &header, sizeof( header ) );
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,51 @@
+#ifndef _CHSMODELWRITER_H
+#define _CHSMODELWRITER_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+
+#include "ChsModelFormat.h"
+#include "ChsFileWriter.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Streams a version 2 file: a placeholder header, every chunk as it is added, then on finish
+//	the table of contents, and the header patched to point at it. Only the table of contents
+//	stays in memory, chunk data can be freed as soon as addChunk returns. Meshes given an entry
+//	get a mesh directory chunk, written by finish.
+//--------------------------------------------------------------------------------------------------
+class ChsModelWriter{
+public:
+  explicit ChsModelWriter( ChsOutputSink & sink );
+  //both before begin
+  void setAlignment( unsigned int value ){
+    alignment = value;
+  }
+  //lz4 for every chunk but the xml, 0 turns it off
+  void setCompression( int chunkSize ){
+    compressedChunkSize = chunkSize;
+  }
+  void begin( void );
+  void addChunk( unsigned int type, unsigned int mesh, unsigned int level, const void * data, size_t size );
+  //after the last chunk of the mesh, its entry spans the chunks added for it since the previous one
+  void addMeshEntry( unsigned int mesh, const char * id, const float boundsMin[3], const float boundsMax[3] );
+  //false when the header could not be patched
+  bool finish( void );
+  size_t chunkCount( void )const{
+    return entries.size();
+  }
+  
+private:
+  ChsModelWriter( const ChsModelWriter & );
+  ChsModelWriter & operator=( const ChsModelWriter & );
+  void pad( unsigned int boundary );
+  
+  ChsOutputSink & sink;
+  std::vector<ChsChunkEntry> entries;
+  std::vector<ChsMeshDirectoryEntry> directory;
+  unsigned long long offset;
+  unsigned int alignment;
+  int compressedChunkSize;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSMODELWRITER_H
@@ -0,0 +1,317 @@
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <algorithm>
+
+#include "ChsOverdrawOptimizer.h"
+#include "ChsMeshOptimizer.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Software rasterizer used only to measure overdraw, six orthographic views along the axes
+//--------------------------------------------------------------------------------------------------
+enum{
+  OVERDRAW_VIEWPORT = 256,
+  OVERDRAW_VIEW_COUNT = 6,
+};
+
+class OverdrawRasterizer {
+public:
+  OverdrawRasterizer( const float * boundsMin, const float * boundsMax );
+  void drawTriangle( const float * a, const float * b, const float * c );
+  void finish( ChsOverdrawStats & stats )const;
+  
+private:
+  float offset[3];
+  float scale;
+  std::vector<float> depthBuffer;
+  int pixelsShaded;
+  
+  void drawView( int view, const float * a, const float * b, const float * c );
+};
+
+//--------------------------------------------------------------------------------------------------
+OverdrawRasterizer::OverdrawRasterizer( const float * boundsMin, const float * boundsMax ){
+  float extent = 0.0f;
+  for( int axis = 0; axis < 3; axis++ ){
+    offset[axis] = boundsMin[axis];
+    extent = std::max( extent, boundsMax[axis] - boundsMin[axis] );
+  }
+  scale = extent > 0.0f ? ( OVERDRAW_VIEWPORT - 1 ) / extent : 0.0f;
+  depthBuffer.assign( OVERDRAW_VIEW_COUNT * OVERDRAW_VIEWPORT * OVERDRAW_VIEWPORT, FLT_MAX );
+  pixelsShaded = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+void OverdrawRasterizer::drawTriangle( const float * a, const float * b, const float * c ){
+  float normal[3] = {
+    ( b[1] - a[1] ) * ( c[2] - a[2] ) - ( b[2] - a[2] ) * ( c[1] - a[1] ),
+    ( b[2] - a[2] ) * ( c[0] - a[0] ) - ( b[0] - a[0] ) * ( c[2] - a[2] ),
+    ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( b[1] - a[1] ) * ( c[0] - a[0] ),
+  };
+  //view 2k looks down +axis k, view 2k+1 looks down -axis k; back faces are culled
+  for( int view = 0; view < OVERDRAW_VIEW_COUNT; view++ ){
+    float facing = normal[view / 2] * ( view & 1 ? -1.0f : 1.0f );
+    if( facing < 0.0f )
+      drawView( view, a, b, c );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void OverdrawRasterizer::drawView( int view, const float * a, const float * b, const float * c ){
+  int depthAxis = view / 2;
+  int xAxis = ( depthAxis + 1 ) % 3;
+  int yAxis = ( depthAxis + 2 ) % 3;
+  float depthSign = view & 1 ? -1.0f : 1.0f;
+  const float * corners[3] = { a, b, c };
+  float x[3], y[3], z[3];
+  for( int k = 0; k < 3; k++ ){
+    x[k] = ( corners[k][xAxis] - offset[xAxis] ) * scale;
+    y[k] = ( corners[k][yAxis] - offset[yAxis] ) * scale;
+    z[k] = ( corners[k][depthAxis] - offset[depthAxis] ) * scale * depthSign;
+  }
+  float area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( x[2] - x[0] ) * ( y[1] - y[0] );
+  if( area == 0.0f )
+    return;
+  float invArea = 1.0f / area;
+  int minX = std::max( 0, (int)floorf( std::min( x[0], std::min( x[1], x[2] ) ) ) );
+  int maxX = std::min( OVERDRAW_VIEWPORT - 1, (int)ceilf( std::max( x[0], std::max( x[1], x[2] ) ) ) );
+  int minY = std::max( 0, (int)floorf( std::min( y[0], std::min( y[1], y[2] ) ) ) );
+  int maxY = std::min( OVERDRAW_VIEWPORT - 1, (int)ceilf( std::max( y[0], std::max( y[1], y[2] ) ) ) );
+  float * buffer = &depthBuffer[view * OVERDRAW_VIEWPORT * OVERDRAW_VIEWPORT];
+  for( int py = minY; py <= maxY; py++ ){
+    float sy = py + 0.5f;
+    for( int px = minX; px <= maxX; px++ ){
+      float sx = px + 0.5f;
+      float w0 = ( ( x[2] - x[1] ) * ( sy - y[1] ) - ( y[2] - y[1] ) * ( sx - x[1] ) ) * invArea;
+      float w1 = ( ( x[0] - x[2] ) * ( sy - y[2] ) - ( y[0] - y[2] ) * ( sx - x[2] ) ) * invArea;
+      float w2 = 1.0f - w0 - w1;
+      if( w0 < 0.0f || w1 < 0.0f || w2 < 0.0f )
+        continue;
+      float depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+      float & stored = buffer[py * OVERDRAW_VIEWPORT + px];
+      if( depth < stored ){
+        stored = depth;
+        pixelsShaded++;
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void OverdrawRasterizer::finish( ChsOverdrawStats & stats )const{
+  stats.pixelsShaded = pixelsShaded;
+  stats.pixelsCovered = 0;
+  for( size_t i = 0; i < depthBuffer.size(); i++ ){
+    if( depthBuffer[i] != FLT_MAX )
+      stats.pixelsCovered++;
+  }
+  stats.overdraw = stats.pixelsCovered ? (float)stats.pixelsShaded / stats.pixelsCovered : 0.0f;
+}
+
+//--------------------------------------------------------------------------------------------------
+static void getBounds( const float * positions, int vertexCount, int positionStride, float * boundsMin, float * boundsMax ){
+  for( int axis = 0; axis < 3; axis++ ){
+    boundsMin[axis] = FLT_MAX;
+    boundsMax[axis] = -FLT_MAX;
+  }
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    const float * pos = positions + vertex * positionStride;
+    for( int axis = 0; axis < 3; axis++ ){
+      boundsMin[axis] = std::min( boundsMin[axis], pos[axis] );
+      boundsMax[axis] = std::max( boundsMax[axis], pos[axis] );
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsOverdrawStats analyzeOverdraw( const unsigned int * indices, int indexCount,
+                                  const float * positions, int vertexCount, int positionStride ){
+  float boundsMin[3], boundsMax[3];
+  getBounds( positions, vertexCount, positionStride, boundsMin, boundsMax );
+  OverdrawRasterizer rasterizer( boundsMin, boundsMax );
+  for( int i = 0; i + 2 < indexCount; i += 3 ){
+    rasterizer.drawTriangle( positions + indices[i] * positionStride,
+                             positions + indices[i + 1] * positionStride,
+                             positions + indices[i + 2] * positionStride );
+  }
+  ChsOverdrawStats stats;
+  rasterizer.finish( stats );
+  return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+//	The cache friendly order is cut into clusters, which are then sorted so that the ones facing
+//	away from the mesh center are drawn first.
+//--------------------------------------------------------------------------------------------------
+static int updateCache( const unsigned int * triangle, std::vector<unsigned int> & timestamps, unsigned int & time ){
+  int misses = 0;
+  for( int k = 0; k < 3; k++ ){
+    if( time - timestamps[triangle[k]] > CHS_VERTEX_CACHE_SIZE ){
+      timestamps[triangle[k]] = time++;
+      misses++;
+    }
+  }
+  return misses;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	a new hard cluster starts wherever a triangle misses on all three vertices
+//--------------------------------------------------------------------------------------------------
+static void generateHardBoundaries( const unsigned int * indices, int triangleCount,
+                                    std::vector<unsigned int> & timestamps, unsigned int & time,
+                                    std::vector<int> & boundaries ){
+  time += CHS_VERTEX_CACHE_SIZE + 1;
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    if( updateCache( indices + triangle * 3, timestamps, time ) == 3 )
+      boundaries.push_back( triangle );
+  }
+  if( boundaries.empty() || boundaries[0] != 0 )
+    boundaries.insert( boundaries.begin(), 0 );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	hard clusters are cut again as soon as their running acmr drops under threshold times the
+//	acmr of the whole hard cluster
+//--------------------------------------------------------------------------------------------------
+static void generateSoftBoundaries( const unsigned int * indices, int triangleCount,
+                                    const std::vector<int> & hardBoundaries, float threshold,
+                                    std::vector<unsigned int> & timestamps, unsigned int & time,
+                                    std::vector<int> & boundaries ){
+  int hardCount = hardBoundaries.size();
+  for( int cluster = 0; cluster < hardCount; cluster++ ){
+    int start = hardBoundaries[cluster];
+    int end = cluster + 1 < hardCount ? hardBoundaries[cluster + 1] : triangleCount;
+    time += CHS_VERTEX_CACHE_SIZE + 1;
+    int clusterMisses = 0;
+    for( int triangle = start; triangle < end; triangle++ )
+      clusterMisses += updateCache( indices + triangle * 3, timestamps, time );
+    float clusterThreshold = threshold * clusterMisses / ( end - start );
+    boundaries.push_back( start );
+    time += CHS_VERTEX_CACHE_SIZE + 1;
+    int runningMisses = 0;
+    int runningTriangles = 0;
+    for( int triangle = start; triangle < end; triangle++ ){
+      runningMisses += updateCache( indices + triangle * 3, timestamps, time );
+      runningTriangles++;
+      if( triangle + 1 < end && runningMisses <= clusterThreshold * runningTriangles ){
+        boundaries.push_back( triangle + 1 );
+        time += CHS_VERTEX_CACHE_SIZE + 1;
+        runningMisses = 0;
+        runningTriangles = 0;
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+struct ClusterKey{
+  float key;
+  int cluster;
+  bool operator < ( const ClusterKey & other )const{
+    return key > other.key || ( key == other.key && cluster < other.cluster );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+void optimizeOverdraw( unsigned int * indices, int indexCount,
+                       const float * positions, int vertexCount, int positionStride, float threshold ){
+  int triangleCount = indexCount / 3;
+  if( triangleCount < 2 )
+    return;
+  std::vector<unsigned int> timestamps( vertexCount, 0 );
+  unsigned int time = 0;
+  std::vector<int> hardBoundaries, boundaries;
+  generateHardBoundaries( indices, triangleCount, timestamps, time, hardBoundaries );
+  generateSoftBoundaries( indices, triangleCount, hardBoundaries, threshold, timestamps, time, boundaries );
+
+  float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    for( int axis = 0; axis < 3; axis++ )
+      meshCenter[axis] += positions[vertex * positionStride + axis] / vertexCount;
+  }
+  int clusterCount = boundaries.size();
+  std::vector<ClusterKey> keys( clusterCount );
+  for( int cluster = 0; cluster < clusterCount; cluster++ ){
+    int start = boundaries[cluster];
+    int end = cluster + 1 < clusterCount ? boundaries[cluster + 1] : triangleCount;
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float normal[3] = { 0.0f, 0.0f, 0.0f };
+    float clusterArea = 0.0f;
+    for( int triangle = start; triangle < end; triangle++ ){
+      const float * a = positions + indices[triangle * 3] * positionStride;
+      const float * b = positions + indices[triangle * 3 + 1] * positionStride;
+      const float * c = positions + indices[triangle * 3 + 2] * positionStride;
+      float n[3] = {
+        ( b[1] - a[1] ) * ( c[2] - a[2] ) - ( b[2] - a[2] ) * ( c[1] - a[1] ),
+        ( b[2] - a[2] ) * ( c[0] - a[0] ) - ( b[0] - a[0] ) * ( c[2] - a[2] ),
+        ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( b[1] - a[1] ) * ( c[0] - a[0] ),
+      };
+      float area = sqrtf( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+      for( int axis = 0; axis < 3; axis++ ){
+        center[axis] += ( a[axis] + b[axis] + c[axis] ) / 3.0f * area;
+        normal[axis] += n[axis];
+      }
+      clusterArea += area;
+    }
+    float invArea = clusterArea > 0.0f ? 1.0f / clusterArea : 0.0f;
+    float length = sqrtf( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+    float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+    float key = 0.0f;
+    for( int axis = 0; axis < 3; axis++ )
+      key += ( center[axis] * invArea - meshCenter[axis] ) * normal[axis] * invLength;
+    keys[cluster].key = key;
+    keys[cluster].cluster = cluster;
+  }
+  std::sort( keys.begin(), keys.end() );
+
+  std::vector<unsigned int> output;
+  output.reserve( indexCount );
+  for( int i = 0; i < clusterCount; i++ ){
+    int cluster = keys[i].cluster;
+    int start = boundaries[cluster];
+    int end = cluster + 1 < clusterCount ? boundaries[cluster + 1] : triangleCount;
+    output.insert( output.end(), indices + start * 3, indices + end * 3 );
+  }
+  std::copy( output.begin(), output.end(), indices );
+}
+
+//--------------------------------------------------------------------------------------------------
+ChsOverdrawStats analyzeMeshOverdraw( const ChsMeshSharedPtr & mesh ){
+  int stride = mesh->vertexStride();
+  const float * positions = mesh->vertexArray.data();
+  float boundsMin[3], boundsMax[3];
+  getBounds( positions, mesh->vertexCount(), stride, boundsMin, boundsMax );
+  OverdrawRasterizer rasterizer( boundsMin, boundsMax );
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    const float * base = positions + submesh.firstVertex * stride;
+    for( int index = submesh.firstIndex; index + 2 < submesh.firstIndex + submesh.indexCount; index += 3 ){
+      rasterizer.drawTriangle( base + indices[index] * stride,
+                               base + indices[index + 1] * stride,
+                               base + indices[index + 2] * stride );
+    }
+  }
+  ChsOverdrawStats stats;
+  rasterizer.finish( stats );
+  return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+void optimizeMeshOverdraw( ChsMeshSharedPtr & mesh, float threshold ){
+  int stride = mesh->vertexStride();
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    if( submesh.indexCount < 3 )
+      continue;
+    optimizeOverdraw( &indices[submesh.firstIndex], submesh.indexCount,
+                      &mesh->vertexArray[submesh.firstVertex * stride], submesh.vertexCount, stride, threshold );
+  }
+  mesh->setIndexArray( indices );
+}
+
+//--------------------------------------------------------------------------------------------------
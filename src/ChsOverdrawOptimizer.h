@@ -0,0 +1,28 @@
+#ifndef _CHSOVERDRAWOPTIMIZER_H
+#define _CHSOVERDRAWOPTIMIZER_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	overdraw: pixels shaded / pixels covered, averaged over six axis aligned views
+//--------------------------------------------------------------------------------------------------
+struct ChsOverdrawStats{
+  float overdraw;
+  int pixelsCovered;
+  int pixelsShaded;
+};
+
+//--------------------------------------------------------------------------------------------------
+ChsOverdrawStats analyzeOverdraw( const unsigned int * indices, int indexCount,
+                                  const float * positions, int vertexCount, int positionStride );
+//	threshold is the cache efficiency given up for overdraw, 1.05 allows clusters 5% worse acmr
+void optimizeOverdraw( unsigned int * indices, int indexCount,
+                       const float * positions, int vertexCount, int positionStride, float threshold );
+
+//--------------------------------------------------------------------------------------------------
+ChsOverdrawStats analyzeMeshOverdraw( const ChsMeshSharedPtr & mesh );
+void optimizeMeshOverdraw( ChsMeshSharedPtr & mesh, float threshold );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSOVERDRAWOPTIMIZER_H
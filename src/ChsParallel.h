@@ -0,0 +1,62 @@
+#ifndef _CHSPARALLEL_H
+#define _CHSPARALLEL_H
+//--------------------------------------------------------------------------------------------------
+#include <boost/thread.hpp>
+
+//--------------------------------------------------------------------------------------------------
+//	Hands out job indices to the worker threads one at a time
+//--------------------------------------------------------------------------------------------------
+class ChsJobCounter {
+public:
+  ChsJobCounter( int count ) : next( 0 ), count( count ){}
+  bool take( int & index ){
+    boost::mutex::scoped_lock lock( mutex );
+    if( next >= count )
+      return false;
+    index = next++;
+    return true;
+  }
+  
+private:
+  boost::mutex mutex;
+  int next;
+  int count;
+};
+
+//--------------------------------------------------------------------------------------------------
+template <typename Job> class ChsParallelWorker {
+public:
+  ChsParallelWorker( Job & job, ChsJobCounter & counter ) : job( job ), counter( counter ){}
+  void operator()( void ){
+    int index;
+    while( counter.take( index ) )
+      job( index );
+  }
+  
+private:
+  Job & job;
+  ChsJobCounter & counter;
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Calls job( i ) for every i in [0, count) on all hardware threads, job must be thread safe
+//--------------------------------------------------------------------------------------------------
+template <typename Job> void parallelFor( int count, Job & job ){
+  int threadCount = boost::thread::hardware_concurrency();
+  if( threadCount > count )
+    threadCount = count;
+  if( threadCount <= 1 ){
+    for( int i = 0; i < count; i++ )
+      job( i );
+    return;
+  }
+  ChsJobCounter counter( count );
+  boost::thread_group threads;
+  for( int i = 0; i < threadCount; i++ )
+    threads.create_thread( ChsParallelWorker<Job>( job, counter ) );
+  threads.join_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSPARALLEL_H
@@ -0,0 +1,285 @@
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#if defined( __SSE__ ) || defined( _M_X64 )
+#define CHS_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "ChsStaticBatcher.h"
+#include "ChsMeshOptimizer.h"
+#include "ChsTangentGenerator.h"
+#include "ChsParallel.h"
+
+//--------------------------------------------------------------------------------------------------
+//	cofactors of the upper 3x3, the inverse transpose up to 1 / det, which renormalizing removes
+//--------------------------------------------------------------------------------------------------
+static float makeNormalMatrix( const float matrix[4][4], float normalMatrix[3][4] ){
+  for( int i = 0; i < 3; i++ ){
+    int i1 = ( i + 1 ) % 3, i2 = ( i + 2 ) % 3;
+    for( int j = 0; j < 3; j++ ){
+      int j1 = ( j + 1 ) % 3, j2 = ( j + 2 ) % 3;
+      normalMatrix[i][j] = matrix[i1][j1] * matrix[i2][j2] - matrix[i1][j2] * matrix[i2][j1];
+    }
+    normalMatrix[i][3] = 0.0f;
+  }
+  float det = matrix[0][0] * normalMatrix[0][0] + matrix[0][1] * normalMatrix[0][1] +
+              matrix[0][2] * normalMatrix[0][2];
+  //keep normals pointing outwards through mirroring transforms
+  if( det < 0.0f ){
+    for( int i = 0; i < 3; i++ )
+      for( int j = 0; j < 3; j++ )
+        normalMatrix[i][j] = -normalMatrix[i][j];
+  }
+  return det;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	tangents are directions in the surface, they take the matrix itself; a mirror flips the
+//	bitangent sign, as the normals were kept pointing outwards
+//--------------------------------------------------------------------------------------------------
+static void transformTangents( float * vertices, int vertexCount, int stride, const float matrix[4][4],
+                               int tangentOffset, bool isMirrored ){
+  for( int i = 0; i < vertexCount; i++, vertices += stride ){
+    float * tangent = vertices + tangentOffset;
+    float transformed[3];
+    for( int axis = 0; axis < 3; axis++ ){
+      transformed[axis] = tangent[0] * matrix[0][axis] + tangent[1] * matrix[1][axis] +
+                          tangent[2] * matrix[2][axis];
+    }
+    float length = sqrtf( transformed[0] * transformed[0] + transformed[1] * transformed[1] +
+                          transformed[2] * transformed[2] );
+    length = std::max( length, 1e-20f );
+    for( int axis = 0; axis < 3; axis++ )
+      tangent[axis] = transformed[axis] / length;
+    tangent[3] = isMirrored ? -tangent[3] : tangent[3];
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void transformVertices( float * vertices, int vertexCount, int stride, const float matrix[4][4],
+                        int tangentOffset ){
+  float normalMatrix[3][4];
+  bool isMirrored = makeNormalMatrix( matrix, normalMatrix ) < 0.0f;
+  if( tangentOffset >= 0 )
+    transformTangents( vertices, vertexCount, stride, matrix, tangentOffset, isMirrored );
+#ifdef CHS_USE_SSE
+  __m128 row0 = _mm_loadu_ps( matrix[0] );
+  __m128 row1 = _mm_loadu_ps( matrix[1] );
+  __m128 row2 = _mm_loadu_ps( matrix[2] );
+  __m128 row3 = _mm_loadu_ps( matrix[3] );
+  __m128 normalRow0 = _mm_loadu_ps( normalMatrix[0] );
+  __m128 normalRow1 = _mm_loadu_ps( normalMatrix[1] );
+  __m128 normalRow2 = _mm_loadu_ps( normalMatrix[2] );
+  float result[4];
+  for( int i = 0; i < vertexCount; i++, vertices += stride ){
+    __m128 position = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( vertices[0] ), row0 ),
+                                              _mm_mul_ps( _mm_set1_ps( vertices[1] ), row1 ) ),
+                                  _mm_add_ps( _mm_mul_ps( _mm_set1_ps( vertices[2] ), row2 ), row3 ) );
+    __m128 normal = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( vertices[3] ), normalRow0 ),
+                                            _mm_mul_ps( _mm_set1_ps( vertices[4] ), normalRow1 ) ),
+                                _mm_mul_ps( _mm_set1_ps( vertices[5] ), normalRow2 ) );
+    //length squared in every lane, w is zero
+    __m128 square = _mm_mul_ps( normal, normal );
+    __m128 sum = _mm_add_ps( square, _mm_shuffle_ps( square, square, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    sum = _mm_add_ps( sum, _mm_shuffle_ps( sum, sum, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    __m128 length = _mm_sqrt_ps( sum );
+    normal = _mm_div_ps( normal, _mm_max_ps( length, _mm_set1_ps( 1e-20f ) ) );
+    _mm_storeu_ps( result, position );
+    std::copy( result, result + 3, vertices );
+    _mm_storeu_ps( result, normal );
+    std::copy( result, result + 3, vertices + 3 );
+  }
+#else
+  for( int i = 0; i < vertexCount; i++, vertices += stride ){
+    float position[3], normal[3];
+    for( int axis = 0; axis < 3; axis++ ){
+      position[axis] = vertices[0] * matrix[0][axis] + vertices[1] * matrix[1][axis] +
+                       vertices[2] * matrix[2][axis] + matrix[3][axis];
+      normal[axis] = vertices[3] * normalMatrix[0][axis] + vertices[4] * normalMatrix[1][axis] +
+                     vertices[5] * normalMatrix[2][axis];
+    }
+    float length = sqrtf( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+    length = std::max( length, 1e-20f );
+    for( int axis = 0; axis < 3; axis++ ){
+      vertices[axis] = position[axis];
+      vertices[3 + axis] = normal[axis] / length;
+    }
+  }
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+static bool isSameMaterial( const ChsMeshMaterial & a, const ChsMeshMaterial & b ){
+  if( a.channels.size() != b.channels.size() )
+    return false;
+  for( size_t i = 0; i < a.channels.size(); i++ ){
+    const ChsMaterialChannelValue & channelA = a.channels[i];
+    const ChsMaterialChannelValue & channelB = b.channels[i];
+    if( channelA.textureFileName != channelB.textureFileName ||
+        channelA.r != channelB.r || channelA.g != channelB.g || channelA.b != channelB.b )
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+static bool isSameLayout( const ChsMesh & a, const ChsMesh & b ){
+  return a.hasUV == b.hasUV && a.hasTexture == b.hasTexture && a.hasVertexColor == b.hasVertexColor &&
+         a.hasTangent == b.hasTangent;
+}
+
+//--------------------------------------------------------------------------------------------------
+static ChsMeshSharedPtr makeBatch( const ChsMesh & source, const ChsMeshMaterial & material, int batchIndex ){
+  ChsMeshSharedPtr batch( new ChsMesh );
+  char name[32];
+  sprintf( name, "batch%d", batchIndex );
+  batch->name = name;
+  batch->hasUV = source.hasUV;
+  batch->hasTexture = source.hasTexture;
+  batch->hasVertexColor = source.hasVertexColor;
+  batch->hasTangent = source.hasTangent;
+  batch->materials.push_back( material );
+  for( int i = 0; i < 4; i++ )
+    for( int j = 0; j < 4; j++ )
+      batch->transform[i][j] = i == j ? 1.0f : 0.0f;
+  ChsSubmesh submesh = { 0, 0, 0, 0, 0 };
+  batch->submeshes.push_back( submesh );
+  return batch;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	appends the vertices one submesh of source uses, in world space, and its triangles
+//--------------------------------------------------------------------------------------------------
+static void appendSubmesh( ChsMesh & batch, std::vector<unsigned int> & batchIndices, const ChsMesh & source,
+                           const std::vector<unsigned int> & sourceIndices, const ChsSubmesh & submesh ){
+  int stride = source.vertexStride();
+  std::vector<unsigned int> indices( sourceIndices.begin() + submesh.firstIndex,
+                                     sourceIndices.begin() + submesh.firstIndex + submesh.indexCount );
+  optimizeVertexCache( indices.data(), indices.size(), submesh.vertexCount );
+  std::vector<int> remap;
+  int usedCount = optimizeVertexFetchRemap( indices.data(), indices.size(), submesh.vertexCount, remap );
+  int firstVertex = batch.vertexArray.size() / stride;
+  batch.vertexArray.resize( batch.vertexArray.size() + usedCount * stride );
+  float * dest = &batch.vertexArray[firstVertex * stride];
+  for( int vertex = 0; vertex < submesh.vertexCount; vertex++ ){
+    if( remap[vertex] < 0 )
+      continue;
+    const float * from = &source.vertexArray[( submesh.firstVertex + vertex ) * stride];
+    std::copy( from, from + stride, dest + remap[vertex] * stride );
+  }
+  //tangents are the last 4 floats
+  transformVertices( dest, usedCount, stride, source.transform, source.hasTangent ? stride - 4 : -1 );
+  float normalMatrix[3][4];
+  bool isMirrored = makeNormalMatrix( source.transform, normalMatrix ) < 0.0f;
+  ChsBatchRange range = { source.name, (int)batchIndices.size(), (int)indices.size() };
+  batch.batchRanges.push_back( range );
+  for( size_t i = 0; i < indices.size(); i += 3 ){
+    //a mirroring transform turns the winding around
+    batchIndices.push_back( firstVertex + indices[i] );
+    batchIndices.push_back( firstVertex + indices[i + ( isMirrored ? 2 : 1 )] );
+    batchIndices.push_back( firstVertex + indices[i + ( isMirrored ? 1 : 2 )] );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void closeBatch( ChsOpenBatch & open, std::vector<ChsMeshSharedPtr> & batches ){
+  ChsSubmesh & submesh = open.mesh->submeshes[0];
+  submesh.vertexCount = open.mesh->vertexCount();
+  submesh.indexCount = open.indices.size();
+  open.mesh->setIndexArray( open.indices );
+  batches.push_back( open.mesh );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	vertices the triangles of a submesh actually use, the submeshes of a built mesh span them all
+//--------------------------------------------------------------------------------------------------
+static int countUsedVertices( const std::vector<unsigned int> & indices, const ChsSubmesh & submesh ){
+  std::vector<bool> isUsed( submesh.vertexCount, false );
+  int usedCount = 0;
+  for( int i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++ ){
+    if( !isUsed[indices[i]] ){
+      isUsed[indices[i]] = true;
+      usedCount++;
+    }
+  }
+  return usedCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+struct TangentJob{
+  std::vector<ChsMeshSharedPtr> * meshList;
+  void operator()( int meshIdx ){
+    ChsMeshSharedPtr & mesh = ( *meshList )[meshIdx];
+    if( !mesh->hasAnimatedTransform )
+      generateTangents( mesh );
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+int batchStaticMeshes( std::vector<ChsMeshSharedPtr> & meshList, ChsBatchState & state, bool isLast,
+                       bool buildTangents, int maxVertexCount ){
+  //tangents split vertices, so they go in before any vertex is counted
+  if( buildTangents ){
+    TangentJob job;
+    job.meshList = &meshList;
+    parallelFor( meshList.size(), job );
+  }
+  std::vector<ChsMeshSharedPtr> keptMeshes;
+  std::vector<ChsMeshSharedPtr> batches;
+  std::vector<ChsOpenBatch> & openBatches = state.openBatches;
+  int batchedCount = 0;
+  for( size_t meshIdx = 0; meshIdx < meshList.size(); meshIdx++ ){
+    const ChsMeshSharedPtr & mesh = meshList[meshIdx];
+    if( mesh->hasAnimatedTransform || mesh->materials.empty() ){
+      keptMeshes.push_back( mesh );
+      continue;
+    }
+    std::vector<unsigned int> indices;
+    mesh->getIndexArray( indices );
+    std::vector<int> usedCounts( mesh->submeshes.size() );
+    bool isOversize = false;
+    for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+      usedCounts[i] = countUsedVertices( indices, mesh->submeshes[i] );
+      isOversize = isOversize || usedCounts[i] > maxVertexCount;
+    }
+    //a submesh no batch could hold, the mesh goes out on its own and may still be split
+    if( isOversize ){
+      keptMeshes.push_back( mesh );
+      continue;
+    }
+    batchedCount++;
+    for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+      const ChsSubmesh & submesh = mesh->submeshes[i];
+      const ChsMeshMaterial & material = mesh->materials[submesh.material];
+      size_t open = 0;
+      while( open < openBatches.size() &&
+             !( isSameLayout( *openBatches[open].mesh, *mesh ) &&
+                isSameMaterial( openBatches[open].mesh->materials[0], material ) ) )
+        open++;
+      if( open < openBatches.size() &&
+          openBatches[open].mesh->vertexCount() + usedCounts[i] > maxVertexCount ){
+        closeBatch( openBatches[open], batches );
+        openBatches.erase( openBatches.begin() + open );
+        open = openBatches.size();
+      }
+      if( open == openBatches.size() ){
+        ChsOpenBatch batch;
+        batch.mesh = makeBatch( *mesh, material, state.batchCount++ );
+        openBatches.push_back( batch );
+      }
+      appendSubmesh( *openBatches[open].mesh, openBatches[open].indices, *mesh, indices, submesh );
+    }
+  }
+  if( isLast ){
+    for( size_t open = 0; open < openBatches.size(); open++ )
+      closeBatch( openBatches[open], batches );
+    openBatches.clear();
+  }
+  keptMeshes.insert( keptMeshes.end(), batches.begin(), batches.end() );
+  meshList.swap( keptMeshes );
+  state.batchedCount += batchedCount;
+  return batchedCount;
+}
+
+//--------------------------------------------------------------------------------------------------
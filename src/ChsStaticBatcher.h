@@ -0,0 +1,48 @@
+#ifndef _CHSSTATICBATCHER_H
+#define _CHSSTATICBATCHER_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+#include <limits.h>
+
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Batches still filling up between calls, so a streamed export batches across its windows while
+//	the source meshes already merged can go
+//--------------------------------------------------------------------------------------------------
+struct ChsOpenBatch{
+  ChsMeshSharedPtr mesh;
+  std::vector<unsigned int> indices;
+};
+
+struct ChsBatchState{
+  std::vector<ChsOpenBatch> openBatches;
+  int batchCount;             //batches made so far, names them
+  int batchedCount;           //source meshes merged so far
+
+  ChsBatchState( void ) : batchCount( 0 ), batchedCount( 0 ){}
+};
+
+//--------------------------------------------------------------------------------------------------
+//	Replaces the static meshes of the list by batches, one per material and vertex layout, with
+//	the world transforms baked into the vertices. Every batch records the index range each source
+//	mesh ended up in, already cache optimized, so the pipeline must keep its triangle order.
+//	A batch is closed once it would address more than maxVertexCount vertices, a mesh with a submesh
+//	using more than that many stays out of the batches. buildTangents generates the tangents of the
+//	static meshes first, their vertex splits count against the limit.
+//	Closed batches join the list, open ones stay in state until a call with isLast set.
+//	Returns the number of meshes that went into batches.
+//--------------------------------------------------------------------------------------------------
+int batchStaticMeshes( std::vector<ChsMeshSharedPtr> & meshList, ChsBatchState & state, bool isLast,
+                       bool buildTangents, int maxVertexCount = USHRT_MAX );
+
+//--------------------------------------------------------------------------------------------------
+//	p * matrix for positions, n * inverse transpose for normals ( row vectors, as Maya stores them ),
+//	t * matrix for the tangents at tangentOffset floats into the vertex unless it is negative
+//--------------------------------------------------------------------------------------------------
+void transformVertices( float * vertices, int vertexCount, int stride, const float matrix[4][4],
+                        int tangentOffset = -1 );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSSTATICBATCHER_H
@@ -0,0 +1,169 @@
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "ChsTangentGenerator.h"
+
+//--------------------------------------------------------------------------------------------------
+static inline float dot( const float * a, const float * b ){
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline bool normalize( float * v ){
+  float length = sqrtf( dot( v, v ) );
+  if( length <= 1e-20f )
+    return false;
+  v[0] /= length;
+  v[1] /= length;
+  v[2] /= length;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	v minus its component along the unit normal n
+//--------------------------------------------------------------------------------------------------
+static inline void project( const float * n, const float * v, float * result ){
+  float d = dot( n, v );
+  result[0] = v[0] - n[0] * d;
+  result[1] = v[1] - n[1] * d;
+  result[2] = v[2] - n[2] * d;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	tangent seen from one triangle, mikktspace vOs, and its uv winding
+//--------------------------------------------------------------------------------------------------
+struct TriangleFrame{
+  float tangent[3];
+  int orientation;    //1 preserving, -1 mirrored, 0 degenerate uv
+};
+
+static void computeTriangleFrame( const float * p0, const float * p1, const float * p2,
+                                  const float * t0, const float * t1, const float * t2, TriangleFrame & frame ){
+  float d1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+  float d2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+  float t21x = t1[0] - t0[0], t21y = t1[1] - t0[1];
+  float t31x = t2[0] - t0[0], t31y = t2[1] - t0[1];
+  float signedArea = t21x * t31y - t21y * t31x;
+  frame.orientation = signedArea > 0.0f ? 1 : ( signedArea < 0.0f ? -1 : 0 );
+  float sign = signedArea > 0.0f ? 1.0f : -1.0f;
+  for( int axis = 0; axis < 3; axis++ )
+    frame.tangent[axis] = ( t31y * d1[axis] - t21y * d2[axis] ) * sign;
+  if( frame.orientation == 0 || !normalize( frame.tangent ) ){
+    frame.tangent[0] = frame.tangent[1] = frame.tangent[2] = 0.0f;
+    frame.orientation = 0;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	any unit vector perpendicular to n, for vertices no triangle gives a direction to
+//--------------------------------------------------------------------------------------------------
+static void makePerpendicular( const float * n, float * tangent ){
+  float axis[3] = { 0.0f, 0.0f, 0.0f };
+  axis[ fabsf( n[0] ) < 0.9f ? 0 : 1 ] = 1.0f;
+  project( n, axis, tangent );
+  if( !normalize( tangent ) ){
+    tangent[0] = 1.0f;
+    tangent[1] = tangent[2] = 0.0f;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void generateTangents( ChsMeshSharedPtr & mesh ){
+  if( !mesh->hasUV || !mesh->hasTexture || mesh->hasTangent )
+    return;
+  int stride = mesh->vertexStride();
+  int vertexCount = mesh->vertexCount();
+  const float * vertices = mesh->vertexArray.data();
+  std::vector<unsigned int> indices;
+  mesh->getIndexArray( indices );
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    const ChsSubmesh & submesh = mesh->submeshes[i];
+    for( int k = submesh.firstIndex; k < submesh.firstIndex + submesh.indexCount; k++ )
+      indices[k] += submesh.firstVertex;
+  }
+  int triangleCount = indices.size() / 3;
+  //two accumulators per vertex, [ 2 * vertex ] preserving and [ 2 * vertex + 1 ] mirrored
+  std::vector<float> accumulated( vertexCount * 2 * 3, 0.0f );
+  std::vector<int> useCount( vertexCount * 2, 0 );
+  std::vector<TriangleFrame> frames( triangleCount );
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    const unsigned int * corner = &indices[triangle * 3];
+    const float * p[3], * t[3];
+    for( int k = 0; k < 3; k++ ){
+      p[k] = vertices + corner[k] * stride;
+      t[k] = p[k] + 6;
+    }
+    TriangleFrame & frame = frames[triangle];
+    computeTriangleFrame( p[0], p[1], p[2], t[0], t[1], t[2], frame );
+    if( frame.orientation == 0 )
+      continue;
+    int group = frame.orientation > 0 ? 0 : 1;
+    for( int k = 0; k < 3; k++ ){
+      const float * n = p[k] + 3;
+      const float * next = p[( k + 1 ) % 3];
+      const float * previous = p[( k + 2 ) % 3];
+      float edge0[3] = { next[0] - p[k][0], next[1] - p[k][1], next[2] - p[k][2] };
+      float edge1[3] = { previous[0] - p[k][0], previous[1] - p[k][1], previous[2] - p[k][2] };
+      float projected0[3], projected1[3], tangent[3];
+      project( n, edge0, projected0 );
+      project( n, edge1, projected1 );
+      project( n, frame.tangent, tangent );
+      if( !normalize( projected0 ) || !normalize( projected1 ) || !normalize( tangent ) )
+        continue;
+      float cosine = dot( projected0, projected1 );
+      float angle = acosf( cosine < -1.0f ? -1.0f : ( cosine > 1.0f ? 1.0f : cosine ) );
+      float * sum = &accumulated[( corner[k] * 2 + group ) * 3];
+      sum[0] += tangent[0] * angle;
+      sum[1] += tangent[1] * angle;
+      sum[2] += tangent[2] * angle;
+      useCount[corner[k] * 2 + group]++;
+    }
+  }
+  //the preserving frame keeps the vertex index, a mirrored one only when it is alone
+  std::vector<int> mirroredVertex( vertexCount );
+  int newVertexCount = vertexCount;
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    bool isPreserving = useCount[vertex * 2] > 0;
+    bool isMirrored = useCount[vertex * 2 + 1] > 0;
+    mirroredVertex[vertex] = ( isPreserving && isMirrored ) ? newVertexCount++ : vertex;
+  }
+  int newStride = stride + 4;
+  std::vector<float> newVertexArray( newVertexCount * newStride );
+  for( int vertex = 0; vertex < vertexCount; vertex++ ){
+    const float * source = vertices + vertex * stride;
+    for( int group = 0; group < 2; group++ ){
+      if( group == 1 && useCount[vertex * 2 + 1] == 0 )
+        continue;
+      int target = group == 0 ? vertex : mirroredVertex[vertex];
+      float * dest = &newVertexArray[target * newStride];
+      std::copy( source, source + stride, dest );
+      float * tangent = dest + stride;
+      //opposite contributions can cancel out, keep what is left only if it is well above noise
+      const float * sum = &accumulated[( vertex * 2 + group ) * 3];
+      project( source + 3, sum, tangent );
+      if( dot( tangent, tangent ) < 1e-8f || !normalize( tangent ) )
+        makePerpendicular( source + 3, tangent );
+      tangent[3] = group == 0 ? 1.0f : -1.0f;
+    }
+  }
+  for( int triangle = 0; triangle < triangleCount; triangle++ ){
+    if( frames[triangle].orientation >= 0 )
+      continue;
+    for( int k = 0; k < 3; k++ ){
+      unsigned int & corner = indices[triangle * 3 + k];
+      corner = mirroredVertex[corner];
+    }
+  }
+  mesh->vertexArray.swap( newVertexArray );
+  mesh->hasTangent = true;
+  for( size_t i = 0; i < mesh->submeshes.size(); i++ ){
+    ChsSubmesh & submesh = mesh->submeshes[i];
+    for( int k = submesh.firstIndex; k < submesh.firstIndex + submesh.indexCount; k++ )
+      indices[k] -= submesh.firstVertex;
+    submesh.vertexCount = newVertexCount - submesh.firstVertex;
+  }
+  mesh->setIndexArray( indices );
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,16 @@
+#ifndef _CHSTANGENTGENERATOR_H
+#define _CHSTANGENTGENERATOR_H
+//--------------------------------------------------------------------------------------------------
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+//	Appends a tangent ( xyz, bitangent sign in w ) to every vertex, following the MikkTSpace rules:
+//	per triangle uv derivatives normalized and signed by the uv winding, projected onto the vertex
+//	normal and weighted by the corner angle. A vertex shared by mirrored and unmirrored triangles
+//	is split in two. Expects the built mesh, where every submesh spans the whole vertex buffer.
+//--------------------------------------------------------------------------------------------------
+void generateTangents( ChsMeshSharedPtr & mesh );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSTANGENTGENERATOR_H
@@ -0,0 +1,306 @@
+#include <string.h>
+
+#include "ChsVertexCodec.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define CHS_VERTEX_CODEC_SSE2
+#include <emmintrin.h>
+#elif defined( __ARM_NEON__ ) || defined( __ARM_NEON )
+#define CHS_VERTEX_CODEC_NEON
+#include <arm_neon.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//	Stream: version byte, channel count byte, one width byte per channel, then for every channel
+//	its width planes of vertexCount bytes, lowest byte first. Little endian throughout.
+//--------------------------------------------------------------------------------------------------
+enum{
+  VERTEX_HEADER = 0xd0,
+  BLOCK_SIZE = 16,
+};
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int widthMask( int width ){
+  return width == 4 ? 0xffffffffu : ( 1u << ( width * 8 ) ) - 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int readValue( const unsigned char * data, int width ){
+  unsigned int value = 0;
+  for( int k = 0; k < width; k++ )
+    value |= (unsigned int)data[k] << ( k * 8 );
+  return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline void writeValue( unsigned char * data, int width, unsigned int value ){
+  for( int k = 0; k < width; k++ )
+    data[k] = (unsigned char)( value >> ( k * 8 ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t encodeVertexBufferBound( int vertexCount, int channelCount ){
+  return 2 + channelCount + (size_t)vertexCount * channelCount * 4;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t encodeVertexBuffer( unsigned char * buffer, size_t bufferSize, const void * vertices, int vertexCount,
+                           const unsigned char * channelWidths, int channelCount ){
+  if( channelCount <= 0 || channelCount > CHS_VERTEX_CODEC_MAX_CHANNELS )
+    return 0;
+  int vertexSize = 0;
+  for( int c = 0; c < channelCount; c++ ){
+    int width = channelWidths[c];
+    if( width != 1 && width != 2 && width != 4 )
+      return 0;
+    vertexSize += width;
+  }
+  size_t size = 2 + channelCount + (size_t)vertexCount * vertexSize;
+  if( bufferSize < size )
+    return 0;
+  buffer[0] = VERTEX_HEADER | CHS_VERTEX_CODEC_VERSION;
+  buffer[1] = (unsigned char)channelCount;
+  memcpy( buffer + 2, channelWidths, channelCount );
+  unsigned char * plane = buffer + 2 + channelCount;
+  const unsigned char * source = static_cast<const unsigned char *>( vertices );
+  int offset = 0;
+  for( int c = 0; c < channelCount; c++ ){
+    int width = channelWidths[c];
+    unsigned int mask = widthMask( width );
+    unsigned int signBit = width * 8 - 1;
+    unsigned int previous = 0;
+    for( int i = 0; i < vertexCount; i++ ){
+      unsigned int value = readValue( source + i * vertexSize + offset, width );
+      unsigned int delta = ( value - previous ) & mask;
+      unsigned int encoded = ( ( delta << 1 ) ^ ( 0u - ( ( delta >> signBit ) & 1 ) ) ) & mask;
+      for( int k = 0; k < width; k++ )
+        plane[k * vertexCount + i] = (unsigned char)( encoded >> ( k * 8 ) );
+      previous = value;
+    }
+    plane += width * vertexCount;
+    offset += width;
+  }
+  return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	Vector helpers for the decoder, one 16 byte register. Shifts move lanes towards the higher
+//	addresses, scans are inclusive prefix sums over lanes of 8, 16 or 32 bits.
+//--------------------------------------------------------------------------------------------------
+#if defined( CHS_VERTEX_CODEC_SSE2 )
+typedef __m128i VertexVector;
+
+static inline VertexVector loadVector( const unsigned char * data ){
+  return _mm_loadu_si128( reinterpret_cast<const __m128i *>( data ) );
+}
+static inline void storeVector( void * data, VertexVector v ){
+  _mm_storeu_si128( reinterpret_cast<__m128i *>( data ), v );
+}
+static inline void zip8( VertexVector a, VertexVector b, VertexVector & low, VertexVector & high ){
+  low = _mm_unpacklo_epi8( a, b );
+  high = _mm_unpackhi_epi8( a, b );
+}
+static inline void zip16( VertexVector a, VertexVector b, VertexVector & low, VertexVector & high ){
+  low = _mm_unpacklo_epi16( a, b );
+  high = _mm_unpackhi_epi16( a, b );
+}
+static inline VertexVector unzigzag8( VertexVector v ){
+  VertexVector one = _mm_set1_epi8( 1 );
+  VertexVector half = _mm_and_si128( _mm_srli_epi16( v, 1 ), _mm_set1_epi8( 0x7f ) );
+  return _mm_xor_si128( half, _mm_sub_epi8( _mm_setzero_si128(), _mm_and_si128( v, one ) ) );
+}
+static inline VertexVector unzigzag16( VertexVector v ){
+  VertexVector sign = _mm_sub_epi16( _mm_setzero_si128(), _mm_and_si128( v, _mm_set1_epi16( 1 ) ) );
+  return _mm_xor_si128( _mm_srli_epi16( v, 1 ), sign );
+}
+static inline VertexVector unzigzag32( VertexVector v ){
+  VertexVector sign = _mm_sub_epi32( _mm_setzero_si128(), _mm_and_si128( v, _mm_set1_epi32( 1 ) ) );
+  return _mm_xor_si128( _mm_srli_epi32( v, 1 ), sign );
+}
+static inline VertexVector scan8( VertexVector v, unsigned int carry ){
+  v = _mm_add_epi8( v, _mm_slli_si128( v, 1 ) );
+  v = _mm_add_epi8( v, _mm_slli_si128( v, 2 ) );
+  v = _mm_add_epi8( v, _mm_slli_si128( v, 4 ) );
+  v = _mm_add_epi8( v, _mm_slli_si128( v, 8 ) );
+  return _mm_add_epi8( v, _mm_set1_epi8( (char)carry ) );
+}
+static inline VertexVector scan16( VertexVector v, unsigned int carry ){
+  v = _mm_add_epi16( v, _mm_slli_si128( v, 2 ) );
+  v = _mm_add_epi16( v, _mm_slli_si128( v, 4 ) );
+  v = _mm_add_epi16( v, _mm_slli_si128( v, 8 ) );
+  return _mm_add_epi16( v, _mm_set1_epi16( (short)carry ) );
+}
+static inline VertexVector scan32( VertexVector v, unsigned int carry ){
+  v = _mm_add_epi32( v, _mm_slli_si128( v, 4 ) );
+  v = _mm_add_epi32( v, _mm_slli_si128( v, 8 ) );
+  return _mm_add_epi32( v, _mm_set1_epi32( (int)carry ) );
+}
+#define CHS_VERTEX_CODEC_SIMD
+#elif defined( CHS_VERTEX_CODEC_NEON )
+typedef uint8x16_t VertexVector;
+
+static inline VertexVector loadVector( const unsigned char * data ){
+  return vld1q_u8( data );
+}
+static inline void storeVector( void * data, VertexVector v ){
+  vst1q_u8( static_cast<uint8_t *>( data ), v );
+}
+static inline void zip8( VertexVector a, VertexVector b, VertexVector & low, VertexVector & high ){
+  uint8x16x2_t zipped = vzipq_u8( a, b );
+  low = zipped.val[0];
+  high = zipped.val[1];
+}
+static inline void zip16( VertexVector a, VertexVector b, VertexVector & low, VertexVector & high ){
+  uint16x8x2_t zipped = vzipq_u16( vreinterpretq_u16_u8( a ), vreinterpretq_u16_u8( b ) );
+  low = vreinterpretq_u8_u16( zipped.val[0] );
+  high = vreinterpretq_u8_u16( zipped.val[1] );
+}
+static inline VertexVector unzigzag8( VertexVector v ){
+  uint8x16_t sign = vsubq_u8( vdupq_n_u8( 0 ), vandq_u8( v, vdupq_n_u8( 1 ) ) );
+  return veorq_u8( vshrq_n_u8( v, 1 ), sign );
+}
+static inline VertexVector unzigzag16( VertexVector v ){
+  uint16x8_t x = vreinterpretq_u16_u8( v );
+  uint16x8_t sign = vsubq_u16( vdupq_n_u16( 0 ), vandq_u16( x, vdupq_n_u16( 1 ) ) );
+  return vreinterpretq_u8_u16( veorq_u16( vshrq_n_u16( x, 1 ), sign ) );
+}
+static inline VertexVector unzigzag32( VertexVector v ){
+  uint32x4_t x = vreinterpretq_u32_u8( v );
+  uint32x4_t sign = vsubq_u32( vdupq_n_u32( 0 ), vandq_u32( x, vdupq_n_u32( 1 ) ) );
+  return vreinterpretq_u8_u32( veorq_u32( vshrq_n_u32( x, 1 ), sign ) );
+}
+static inline VertexVector scan8( VertexVector v, unsigned int carry ){
+  uint8x16_t zero = vdupq_n_u8( 0 );
+  v = vaddq_u8( v, vextq_u8( zero, v, 15 ) );
+  v = vaddq_u8( v, vextq_u8( zero, v, 14 ) );
+  v = vaddq_u8( v, vextq_u8( zero, v, 12 ) );
+  v = vaddq_u8( v, vextq_u8( zero, v, 8 ) );
+  return vaddq_u8( v, vdupq_n_u8( (uint8_t)carry ) );
+}
+static inline VertexVector scan16( VertexVector v, unsigned int carry ){
+  uint8x16_t zero = vdupq_n_u8( 0 );
+  uint16x8_t x = vreinterpretq_u16_u8( v );
+  x = vaddq_u16( x, vreinterpretq_u16_u8( vextq_u8( zero, vreinterpretq_u8_u16( x ), 14 ) ) );
+  x = vaddq_u16( x, vreinterpretq_u16_u8( vextq_u8( zero, vreinterpretq_u8_u16( x ), 12 ) ) );
+  x = vaddq_u16( x, vreinterpretq_u16_u8( vextq_u8( zero, vreinterpretq_u8_u16( x ), 8 ) ) );
+  return vreinterpretq_u8_u16( vaddq_u16( x, vdupq_n_u16( (uint16_t)carry ) ) );
+}
+static inline VertexVector scan32( VertexVector v, unsigned int carry ){
+  uint8x16_t zero = vdupq_n_u8( 0 );
+  uint32x4_t x = vreinterpretq_u32_u8( v );
+  x = vaddq_u32( x, vreinterpretq_u32_u8( vextq_u8( zero, vreinterpretq_u8_u32( x ), 12 ) ) );
+  x = vaddq_u32( x, vreinterpretq_u32_u8( vextq_u8( zero, vreinterpretq_u8_u32( x ), 8 ) ) );
+  return vreinterpretq_u8_u32( vaddq_u32( x, vdupq_n_u32( carry ) ) );
+}
+#define CHS_VERTEX_CODEC_SIMD
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//	16 vertices of one channel, lanes are written to dest with the vertex stride
+//--------------------------------------------------------------------------------------------------
+#ifdef CHS_VERTEX_CODEC_SIMD
+static unsigned int decodeBlock1( const unsigned char * plane, unsigned int carry, unsigned char * dest, int stride ){
+  unsigned char lanes[16];
+  storeVector( lanes, scan8( unzigzag8( loadVector( plane ) ), carry ) );
+  for( int k = 0; k < 16; k++ )
+    dest[k * stride] = lanes[k];
+  return lanes[15];
+}
+
+//--------------------------------------------------------------------------------------------------
+static unsigned int decodeBlock2( const unsigned char * plane, int planeSize, unsigned int carry,
+                                  unsigned char * dest, int stride ){
+  VertexVector halves[2];
+  zip8( loadVector( plane ), loadVector( plane + planeSize ), halves[0], halves[1] );
+  unsigned short lanes[8];
+  for( int h = 0; h < 2; h++ ){
+    storeVector( lanes, scan16( unzigzag16( halves[h] ), carry ) );
+    for( int k = 0; k < 8; k++ )
+      memcpy( dest + ( h * 8 + k ) * stride, &lanes[k], 2 );
+    carry = lanes[7];
+  }
+  return carry;
+}
+
+//--------------------------------------------------------------------------------------------------
+static unsigned int decodeBlock4( const unsigned char * plane, int planeSize, unsigned int carry,
+                                  unsigned char * dest, int stride ){
+  VertexVector low[2], high[2], quarters[4];
+  zip8( loadVector( plane ), loadVector( plane + planeSize ), low[0], low[1] );
+  zip8( loadVector( plane + planeSize * 2 ), loadVector( plane + planeSize * 3 ), high[0], high[1] );
+  zip16( low[0], high[0], quarters[0], quarters[1] );
+  zip16( low[1], high[1], quarters[2], quarters[3] );
+  unsigned int lanes[4];
+  for( int q = 0; q < 4; q++ ){
+    storeVector( lanes, scan32( unzigzag32( quarters[q] ), carry ) );
+    for( int k = 0; k < 4; k++ )
+      memcpy( dest + ( q * 4 + k ) * stride, &lanes[k], 4 );
+    carry = lanes[3];
+  }
+  return carry;
+}
+#endif
+
+//--------------------------------------------------------------------------------------------------
+static unsigned int decodeScalar( const unsigned char * plane, int planeSize, int width, unsigned int carry,
+                                  int count, unsigned char * dest, int stride ){
+  unsigned int mask = widthMask( width );
+  for( int i = 0; i < count; i++ ){
+    unsigned int encoded = 0;
+    for( int k = 0; k < width; k++ )
+      encoded |= (unsigned int)plane[k * planeSize + i] << ( k * 8 );
+    unsigned int delta = ( encoded >> 1 ) ^ ( 0u - ( encoded & 1 ) );
+    carry = ( carry + delta ) & mask;
+    writeValue( dest + i * stride, width, carry );
+  }
+  return carry;
+}
+
+//--------------------------------------------------------------------------------------------------
+int decodeVertexBuffer( void * destination, int vertexCount, int vertexSize,
+                        const unsigned char * buffer, size_t bufferSize ){
+  if( bufferSize < 2 || buffer[0] != ( VERTEX_HEADER | CHS_VERTEX_CODEC_VERSION ) )
+    return -1;
+  int channelCount = buffer[1];
+  if( channelCount == 0 || bufferSize < (size_t)2 + channelCount )
+    return -1;
+  const unsigned char * channelWidths = buffer + 2;
+  int widthSum = 0;
+  for( int c = 0; c < channelCount; c++ ){
+    int width = channelWidths[c];
+    if( width != 1 && width != 2 && width != 4 )
+      return -1;
+    widthSum += width;
+  }
+  if( widthSum != vertexSize || bufferSize != 2 + channelCount + (size_t)vertexCount * vertexSize )
+    return -1;
+  unsigned char * vertices = static_cast<unsigned char *>( destination );
+  unsigned int carries[CHS_VERTEX_CODEC_MAX_CHANNELS];
+  memset( carries, 0, sizeof( carries ) );
+  //block by block so the written vertices stay in cache while every channel fills them
+  for( int first = 0; first < vertexCount; first += BLOCK_SIZE ){
+    int count = vertexCount - first < BLOCK_SIZE ? vertexCount - first : BLOCK_SIZE;
+    const unsigned char * plane = channelWidths + channelCount;
+    unsigned char * dest = vertices + first * vertexSize;
+    for( int c = 0; c < channelCount; c++ ){
+      int width = channelWidths[c];
+#ifdef CHS_VERTEX_CODEC_SIMD
+      if( count == BLOCK_SIZE ){
+        if( width == 1 )
+          carries[c] = decodeBlock1( plane + first, carries[c], dest, vertexSize );
+        else if( width == 2 )
+          carries[c] = decodeBlock2( plane + first, vertexCount, carries[c], dest, vertexSize );
+        else
+          carries[c] = decodeBlock4( plane + first, vertexCount, carries[c], dest, vertexSize );
+      }
+      else
+#endif
+      carries[c] = decodeScalar( plane + first, vertexCount, width, carries[c], count, dest, vertexSize );
+      plane += width * vertexCount;
+      dest += width;
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
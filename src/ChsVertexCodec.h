@@ -0,0 +1,31 @@
+#ifndef _CHSVERTEXCODEC_H
+#define _CHSVERTEXCODEC_H
+//--------------------------------------------------------------------------------------------------
+#include <stddef.h>
+
+//--------------------------------------------------------------------------------------------------
+//	Lossless vertex filter to run ahead of a general purpose compressor. The vertex is cut into
+//	channels of 1, 2 or 4 bytes ( one per attribute component, padding in 1 byte channels ), each
+//	channel is delta coded against the previous vertex as a wrapping integer, zigzagged, and its
+//	bytes are stored as planes of vertexCount bytes. Best on fetch optimized buffers, where the
+//	previous vertex is the previous one in first use order. Output is as large as the input plus
+//	a header naming the channels, so the decoder needs only the vertex count and size.
+//	Self contained, the decoder uses SSE2 or NEON when the target has them.
+//--------------------------------------------------------------------------------------------------
+enum{
+  CHS_VERTEX_CODEC_VERSION = 1,
+  CHS_VERTEX_CODEC_MAX_CHANNELS = 255,
+};
+
+//--------------------------------------------------------------------------------------------------
+size_t encodeVertexBufferBound( int vertexCount, int channelCount );
+//channel widths must add up to the vertex size, returns the encoded size, 0 on bad input
+size_t encodeVertexBuffer( unsigned char * buffer, size_t bufferSize, const void * vertices, int vertexCount,
+                           const unsigned char * channelWidths, int channelCount );
+//returns 0 on success, -1 on malformed input
+int decodeVertexBuffer( void * destination, int vertexCount, int vertexSize,
+                        const unsigned char * buffer, size_t bufferSize );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSVERTEXCODEC_H
@@ -0,0 +1,307 @@
+#include <math.h>
+#include <string.h>
+#include <float.h>
+#include <vector>
+
+#include "ChsVertexEncoder.h"
+
+//--------------------------------------------------------------------------------------------------
+int vertexAttributeTypeSize( int type ){
+  static const int sizes[CHS_TYPE_MAX] = { 4, 2, 2, 2, 1, 1 };
+  return sizes[type];
+}
+
+//--------------------------------------------------------------------------------------------------
+//	round to nearest even, overflow goes to infinity, tiny values to signed zero
+//--------------------------------------------------------------------------------------------------
+unsigned short floatToHalf( float value ){
+  union{ float f; unsigned int u; } bits;
+  bits.f = value;
+  unsigned int sign = ( bits.u >> 16 ) & 0x8000;
+  unsigned int floatExponent = ( bits.u >> 23 ) & 0xff;
+  unsigned int mantissa = bits.u & 0x7fffff;
+  if( floatExponent == 0xff )
+    return sign | 0x7c00 | ( mantissa ? 0x200 : 0 );
+  int exponent = (int)floatExponent - 127 + 15;
+  if( exponent >= 31 )
+    return sign | 0x7c00;
+  if( exponent <= 0 ){
+    if( exponent < -10 )
+      return sign;
+    mantissa |= 0x800000;
+    int shift = 14 - exponent;
+    unsigned int half = mantissa >> shift;
+    unsigned int rest = mantissa & ( ( 1u << shift ) - 1 );
+    unsigned int halfway = 1u << ( shift - 1 );
+    if( rest > halfway || ( rest == halfway && ( half & 1 ) ) )
+      half++;
+    return sign | half;
+  }
+  //a carry out of the mantissa correctly bumps the exponent
+  unsigned int half = ( exponent << 10 ) | ( mantissa >> 13 );
+  unsigned int rest = mantissa & 0x1fff;
+  if( rest > 0x1000 || ( rest == 0x1000 && ( half & 1 ) ) )
+    half++;
+  return sign | half;
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline float clampUnit( float value, float low ){
+  return value < low ? low : ( value > 1.0f ? 1.0f : value );
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline int quantizeSnorm( float value, int maxValue ){
+  float scaled = clampUnit( value, -1.0f ) * maxValue;
+  return (int)( scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f );
+}
+
+//--------------------------------------------------------------------------------------------------
+static inline int quantizeUnorm( float value, int maxValue ){
+  return (int)( clampUnit( value, 0.0f ) * maxValue + 0.5f );
+}
+
+//--------------------------------------------------------------------------------------------------
+//	project onto the octahedron |x|+|y|+|z| = 1 and fold the lower half over the diagonals
+//--------------------------------------------------------------------------------------------------
+static void encodeOctahedron( const float * normal, float & u, float & v ){
+  float x = normal[0], y = normal[1], z = normal[2];
+  float length = fabsf( x ) + fabsf( y ) + fabsf( z );
+  if( length == 0.0f ){
+    u = v = 0.0f;
+    return;
+  }
+  x /= length;
+  y /= length;
+  if( z < 0.0f ){
+    float foldX = ( 1.0f - fabsf( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+    float foldY = ( 1.0f - fabsf( x ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+    x = foldX;
+    y = foldY;
+  }
+  u = x;
+  v = y;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	attributes go to the last stream, positions always open the first one
+//--------------------------------------------------------------------------------------------------
+static void addAttribute( ChsMesh & mesh, int id, int components, int type, bool normalized ){
+  ChsVertexStream & stream = mesh.streams.back();
+  ChsVertexAttribute attribute = { id, components, type, normalized, stream.stride,
+                                   (int)mesh.streams.size() - 1 };
+  mesh.attributes.push_back( attribute );
+  int size = components * vertexAttributeTypeSize( type );
+  stream.stride += ( size + 3 ) & ~3;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	with splitStreams positions get a stream of their own for depth only passes
+//--------------------------------------------------------------------------------------------------
+static void makeLayout( ChsMesh & mesh, bool quantize, int normalBits, bool splitStreams ){
+  ChsVertexStream stream = { 0, 0 };
+  mesh.attributes.clear();
+  mesh.streams.assign( 1, stream );
+  if( quantize ){
+    addAttribute( mesh, CHS_ATTRIBUTE_POSITION, 3, CHS_TYPE_UNSIGNED_SHORT, true );
+    if( splitStreams )
+      mesh.streams.push_back( stream );
+    addAttribute( mesh, CHS_ATTRIBUTE_NORMAL, 2, normalBits == 8 ? CHS_TYPE_BYTE : CHS_TYPE_SHORT, true );
+    if( mesh.hasUV && mesh.hasTexture )
+      addAttribute( mesh, CHS_ATTRIBUTE_TEXCOORD0, 2, CHS_TYPE_HALF_FLOAT, false );
+    if( mesh.hasVertexColor )
+      addAttribute( mesh, CHS_ATTRIBUTE_COLOR, 4, CHS_TYPE_UNSIGNED_BYTE, true );
+    if( mesh.hasTangent )
+      addAttribute( mesh, CHS_ATTRIBUTE_TANGENT, 4, normalBits == 8 ? CHS_TYPE_BYTE : CHS_TYPE_SHORT, true );
+  }
+  else{
+    addAttribute( mesh, CHS_ATTRIBUTE_POSITION, 3, CHS_TYPE_FLOAT, false );
+    if( splitStreams )
+      mesh.streams.push_back( stream );
+    addAttribute( mesh, CHS_ATTRIBUTE_NORMAL, 3, CHS_TYPE_FLOAT, false );
+    if( mesh.hasUV && mesh.hasTexture )
+      addAttribute( mesh, CHS_ATTRIBUTE_TEXCOORD0, 2, CHS_TYPE_FLOAT, false );
+    if( mesh.hasVertexColor )
+      addAttribute( mesh, CHS_ATTRIBUTE_COLOR, 4, CHS_TYPE_FLOAT, false );
+    if( mesh.hasTangent )
+      addAttribute( mesh, CHS_ATTRIBUTE_TANGENT, 4, CHS_TYPE_FLOAT, false );
+  }
+  //streams are stored one after the other
+  int vertexCount = mesh.vertexCount();
+  mesh.vertexSize = 0;
+  for( size_t i = 0; i < mesh.streams.size(); i++ ){
+    mesh.streams[i].offset = mesh.vertexSize * vertexCount;
+    mesh.vertexSize += mesh.streams[i].stride;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void computePositionRange( ChsMesh & mesh ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for( int i = 0; i < vertexCount; i++ ){
+    const float * position = &mesh.vertexArray[i * stride];
+    for( int axis = 0; axis < 3; axis++ ){
+      minimum[axis] = position[axis] < minimum[axis] ? position[axis] : minimum[axis];
+      maximum[axis] = position[axis] > maximum[axis] ? position[axis] : maximum[axis];
+    }
+  }
+  for( int axis = 0; axis < 3; axis++ ){
+    if( vertexCount == 0 )
+      minimum[axis] = maximum[axis] = 0.0f;
+    mesh.positionOffset[axis] = minimum[axis];
+    mesh.positionScale[axis] = maximum[axis] > minimum[axis] ? maximum[axis] - minimum[axis] : 1.0f;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+//	one loop per attribute, source walks the float vertices, dest the attribute in the packed ones
+//--------------------------------------------------------------------------------------------------
+static void encodePositions( const ChsMesh & mesh, const float * source, unsigned char * dest, int destStride ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  float inverseScale[3];
+  for( int axis = 0; axis < 3; axis++ )
+    inverseScale[axis] = 1.0f / mesh.positionScale[axis];
+  for( int i = 0; i < vertexCount; i++, source += stride, dest += destStride ){
+    unsigned short * value = reinterpret_cast<unsigned short *>( dest );
+    for( int axis = 0; axis < 3; axis++ )
+      value[axis] = quantizeUnorm( ( source[axis] - mesh.positionOffset[axis] ) * inverseScale[axis], USHRT_MAX );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Component> void encodeNormals( const ChsMesh & mesh, const float * source,
+                                                  unsigned char * dest, int destStride, int maxValue ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  for( int i = 0; i < vertexCount; i++, source += stride, dest += destStride ){
+    float u, v;
+    encodeOctahedron( source, u, v );
+    Component * value = reinterpret_cast<Component *>( dest );
+    value[0] = quantizeSnorm( u, maxValue );
+    value[1] = quantizeSnorm( v, maxValue );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void encodeFloats( const ChsMesh & mesh, const float * source, unsigned char * dest, int destStride,
+                          int components ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  for( int i = 0; i < vertexCount; i++, source += stride, dest += destStride )
+    memcpy( dest, source, components * sizeof( float ) );
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Component> void encodeTangents( const ChsMesh & mesh, const float * source,
+                                                   unsigned char * dest, int destStride, int maxValue ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  for( int i = 0; i < vertexCount; i++, source += stride, dest += destStride ){
+    Component * value = reinterpret_cast<Component *>( dest );
+    for( int k = 0; k < 4; k++ )
+      value[k] = quantizeSnorm( source[k], maxValue );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void encodeTexcoords( const ChsMesh & mesh, const float * source, unsigned char * dest, int destStride ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  for( int i = 0; i < vertexCount; i++, source += stride, dest += destStride ){
+    unsigned short * value = reinterpret_cast<unsigned short *>( dest );
+    value[0] = floatToHalf( source[0] );
+    value[1] = floatToHalf( source[1] );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void encodeColors( const ChsMesh & mesh, const float * source, unsigned char * dest, int destStride ){
+  int stride = mesh.vertexStride();
+  int vertexCount = mesh.vertexCount();
+  for( int i = 0; i < vertexCount; i++, source += stride, dest += destStride ){
+    for( int channel = 0; channel < 4; channel++ )
+      dest[channel] = quantizeUnorm( source[channel], UCHAR_MAX );
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void encodeAttribute( ChsMesh & mesh, const ChsVertexAttribute & attribute, int sourceOffset ){
+  const ChsVertexStream & stream = mesh.streams[attribute.stream];
+  const float * source = mesh.vertexArray.data() + sourceOffset;
+  unsigned char * dest = mesh.vertexData.data() + stream.offset + attribute.offset;
+  if( attribute.type == CHS_TYPE_FLOAT ){
+    encodeFloats( mesh, source, dest, stream.stride, attribute.components );
+    return;
+  }
+  switch( attribute.id ){
+    case CHS_ATTRIBUTE_POSITION:
+      encodePositions( mesh, source, dest, stream.stride );
+      break;
+    case CHS_ATTRIBUTE_NORMAL:
+      if( attribute.type == CHS_TYPE_BYTE )
+        encodeNormals<signed char>( mesh, source, dest, stream.stride, SCHAR_MAX );
+      else
+        encodeNormals<short>( mesh, source, dest, stream.stride, SHRT_MAX );
+      break;
+    case CHS_ATTRIBUTE_TEXCOORD0:
+      encodeTexcoords( mesh, source, dest, stream.stride );
+      break;
+    case CHS_ATTRIBUTE_COLOR:
+      encodeColors( mesh, source, dest, stream.stride );
+      break;
+    case CHS_ATTRIBUTE_TANGENT:
+      if( attribute.type == CHS_TYPE_BYTE )
+        encodeTangents<signed char>( mesh, source, dest, stream.stride, SCHAR_MAX );
+      else
+        encodeTangents<short>( mesh, source, dest, stream.stride, SHRT_MAX );
+      break;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void makeVertexChannels( const ChsMesh & mesh, int stream, std::vector<unsigned char> & widths ){
+  widths.clear();
+  int offset = 0;
+  //attributes of a stream are added in offset order
+  for( size_t i = 0; i < mesh.attributes.size(); i++ ){
+    const ChsVertexAttribute & attribute = mesh.attributes[i];
+    if( attribute.stream != stream )
+      continue;
+    widths.resize( widths.size() + attribute.offset - offset, 1 );
+    int typeSize = vertexAttributeTypeSize( attribute.type );
+    widths.resize( widths.size() + attribute.components, typeSize );
+    offset = attribute.offset + attribute.components * typeSize;
+  }
+  widths.resize( widths.size() + mesh.streams[stream].stride - offset, 1 );
+}
+
+//--------------------------------------------------------------------------------------------------
+void encodeMeshVertices( ChsMeshSharedPtr & mesh, bool quantize, int normalBits, bool splitStreams ){
+  makeLayout( *mesh, quantize, normalBits, splitStreams );
+  mesh->isQuantized = quantize;
+  int vertexCount = mesh->vertexCount();
+  if( !quantize && mesh->streams.size() == 1 ){
+    //the float interleaved layout is vertexArray itself
+    mesh->vertexData.resize( mesh->vertexArray.size() * sizeof( float ) );
+    if( !mesh->vertexArray.empty() )
+      memcpy( mesh->vertexData.data(), mesh->vertexArray.data(), mesh->vertexData.size() );
+    return;
+  }
+  if( quantize )
+    computePositionRange( *mesh );
+  mesh->vertexData.assign( vertexCount * mesh->vertexSize, 0 );
+  //attributes are laid out in vertexArray order, only the components differ
+  static const int sourceComponents[CHS_ATTRIBUTE_MAX] = { 3, 3, 2, 4, 4 };
+  int sourceOffset = 0;
+  for( size_t i = 0; i < mesh->attributes.size(); i++ ){
+    const ChsVertexAttribute & attribute = mesh->attributes[i];
+    encodeAttribute( *mesh, attribute, sourceOffset );
+    sourceOffset += sourceComponents[attribute.id];
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
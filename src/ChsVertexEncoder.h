@@ -0,0 +1,29 @@
+#ifndef _CHSVERTEXENCODER_H
+#define _CHSVERTEXENCODER_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+
+#include "ChsMesh.h"
+
+//--------------------------------------------------------------------------------------------------
+int vertexAttributeTypeSize( int type );
+unsigned short floatToHalf( float value );
+
+//--------------------------------------------------------------------------------------------------
+//	Fills the mesh attribute layout and vertexData from vertexArray, the last step before writing.
+//	Without quantize the layout is the plain float one. With it positions become 16 bit normalized
+//	inside the mesh bounds, normals octahedral snorm with normalBits ( 8 or 16 ) per component,
+//	texcoords half floats and colors rgba8. Every attribute starts 4 byte aligned.
+//	splitStreams writes positions as a stream of their own followed by the other attributes.
+//--------------------------------------------------------------------------------------------------
+void encodeMeshVertices( ChsMeshSharedPtr & mesh, bool quantize, int normalBits = 16,
+                         bool splitStreams = false );
+
+//--------------------------------------------------------------------------------------------------
+//	byte widths of the components of one stream in vertex order, padding as 1 byte channels
+//--------------------------------------------------------------------------------------------------
+void makeVertexChannels( const ChsMesh & mesh, int stream, std::vector<unsigned char> & widths );
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSVERTEXENCODER_H
@@ -0,0 +1,122 @@
+#ifndef _CHSVERTEXWELDER_H
+#define _CHSVERTEXWELDER_H
+//--------------------------------------------------------------------------------------------------
+#include <vector>
+#include <string.h>
+
+//--------------------------------------------------------------------------------------------------
+//	Open addressing index over face-vertex attribute tuples.
+//	Unit must be a plain struct made only of ints; every field takes part in hash and compare.
+//	Indices are handed out in first-seen order, so the output matches a linear scan of the list.
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> class ChsVertexWelder {
+public:
+  ChsVertexWelder( void ) : mask( 0 ){}
+  void reset( int expectedCount );
+  int weld( const Unit & unit );
+  int find( const Unit & unit )const;
+  inline const std::vector<Unit> & units( void )const;
+  inline int count( void )const;
+
+private:
+  enum{ EMPTY_SLOT = -1 };
+  std::vector<Unit> unitList;
+  std::vector<int> slots;
+  unsigned int mask;
+
+  void rehash( unsigned int slotCount );
+  static unsigned int hash( const Unit & unit );
+};
+
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> inline const std::vector<Unit> & ChsVertexWelder<Unit>::units( void )const{
+  return unitList;
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> inline int ChsVertexWelder<Unit>::count( void )const{
+  return unitList.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> void ChsVertexWelder<Unit>::reset( int expectedCount ){
+  unitList.clear();
+  unitList.reserve( expectedCount );
+  unsigned int slotCount = 16;
+  while( slotCount < (unsigned int)expectedCount * 2 )
+    slotCount <<= 1;
+  slots.assign( slotCount, EMPTY_SLOT );
+  mask = slotCount - 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> unsigned int ChsVertexWelder<Unit>::hash( const Unit & unit ){
+  const int * fields = reinterpret_cast<const int *>( &unit );
+  unsigned int h = 2166136261u;
+  for( unsigned int i = 0; i < sizeof( Unit ) / sizeof( int ); i++ ){
+    unsigned int k = fields[i];
+    k *= 0xcc9e2d51u;
+    k = ( k << 15 ) | ( k >> 17 );
+    k *= 0x1b873593u;
+    h ^= k;
+    h = ( h << 13 ) | ( h >> 19 );
+    h = h * 5 + 0xe6546b64u;
+  }
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  return h;
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> void ChsVertexWelder<Unit>::rehash( unsigned int slotCount ){
+  slots.assign( slotCount, EMPTY_SLOT );
+  mask = slotCount - 1;
+  int unitCount = unitList.size();
+  for( int index = 0; index < unitCount; index++ ){
+    unsigned int slot = hash( unitList[index] ) & mask;
+    while( slots[slot] != EMPTY_SLOT )
+      slot = ( slot + 1 ) & mask;
+    slots[slot] = index;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> int ChsVertexWelder<Unit>::weld( const Unit & unit ){
+  if( slots.empty() )
+    reset( 0 );
+  unsigned int slot = hash( unit ) & mask;
+  //linear probing, the table is kept at most half full
+  while( slots[slot] != EMPTY_SLOT ){
+    int index = slots[slot];
+    if( !memcmp( &unitList[index], &unit, sizeof( Unit ) ) )
+      return index;
+    slot = ( slot + 1 ) & mask;
+  }
+  int index = unitList.size();
+  unitList.push_back( unit );
+  slots[slot] = index;
+  if( unitList.size() * 2 > slots.size() )
+    rehash( slots.size() * 2 );
+  return index;
+}
+
+//--------------------------------------------------------------------------------------------------
+//	index of an already welded unit, -1 if it was never seen
+//--------------------------------------------------------------------------------------------------
+template <typename Unit> int ChsVertexWelder<Unit>::find( const Unit & unit )const{
+  if( slots.empty() )
+    return -1;
+  unsigned int slot = hash( unit ) & mask;
+  while( slots[slot] != EMPTY_SLOT ){
+    int index = slots[slot];
+    if( !memcmp( &unitList[index], &unit, sizeof( Unit ) ) )
+      return index;
+    slot = ( slot + 1 ) & mask;
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+#endif//_CHSVERTEXWELDER_H